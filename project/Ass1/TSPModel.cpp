@@ -1,37 +1,69 @@
 #include "cpxmacro.h"
 #include "TSPModel.h"
-#include <cstdio>
+#include <algorithm>
 #include <iostream>
+#include <string>
 
 using namespace std;
 
-static const int NAME_SIZE = 512;
-static char name[NAME_SIZE];
 char errmsg[BUF_SIZE];
 int status;
 
-TSPModel::TSPModel(const TSPInstance& instance): inst(instance),lp_status(-1),obj_value(0.0),solving_time(0.0),time_limit(0.0) {
+TSPModel::TSPModel(const TSPInstance& instance): inst(instance),env(nullptr),lp(nullptr),lp_status(-1),obj_value(0.0),gap(0.0),solving_time(0.0),build_time(0.0),time_limit(0.0),start_value(0.0) {
     map_y.assign(inst.n, vector<int>(inst.n, -1));
     map_x.assign(inst.n, vector<int>(inst.n, -1));
 }
 
+TSPModel::~TSPModel() {
+    if (lp) CPXfreeprob(env, &lp);
+    if (env) CPXcloseCPLEX(&env);
+}
+
+// rows of the model in compressed sparse row form, added to the problem with a single CPXaddrows call
+struct RowBlock {
+    vector<int> beg;
+    vector<int> ind;
+    vector<double> val;
+    vector<double> rhs;
+    vector<char> sense;
+
+    void begin(char s, double r) {
+        beg.push_back((int)ind.size());
+        sense.push_back(s);
+        rhs.push_back(r);
+    }
+    void add(int column, double coef) {
+        ind.push_back(column);
+        val.push_back(coef);
+    }
+};
+
+// all the columns go in with one CPXnewcols call and all the rows with one CPXaddrows call, in the same order
+// as one call per column and per row would add them; the column names are only built for the LP file
 void TSPModel::setupLP(CEnv env, Prob lp) {
     int position = 0;
     int n = inst.n;
-    const vector<vector<double>>& c = inst.cost;
+    bool named = !lp_file.empty();
+
+    size_t ncols = (size_t)(n - 1) * (n - 1) + (size_t)n * (n - 1);
+    vector<double> obj, lb, ub;
+    vector<char> type;
+    vector<string> names;
+    obj.reserve(ncols);
+    lb.reserve(ncols);
+    ub.reserve(ncols);
+    type.reserve(ncols);
+    if (named) names.reserve(ncols);
 
     // x_ij continuous, only if i != j AND j != 0
     for (int i = 0; i < n; i++) {
         for (int j = 1; j < n; j++) {
             if (i != j) {
-                char type = 'C'; 
-                double lb = 0.0;
-                double ub = CPX_INFBOUND;
-                double obj = 0.0;
-                snprintf(name, NAME_SIZE, "x_%d_%d", i, j);
-                char* cname = &name[0];
-
-                CHECKED_CPX_CALL(CPXnewcols, env, lp, 1, &obj, &lb, &ub, &type, &cname);
+                type.push_back('C');
+                lb.push_back(0.0);
+                ub.push_back(CPX_INFBOUND);
+                obj.push_back(0.0);
+                if (named) names.push_back("x_" + to_string(i) + "_" + to_string(j));
 
                 map_x[i][j] = position;
                 position++;
@@ -43,14 +75,11 @@ void TSPModel::setupLP(CEnv env, Prob lp) {
     for (int i = 0; i < n; i++) {
         for (int j = 0; j < n; j++) {
             if (i != j){
-                char type = 'B'; 
-                double lb = 0.0;
-                double ub = 1.0;
-                double obj = c[i][j];
-                snprintf(name, NAME_SIZE, "y_%d_%d", i, j);
-                char* cname = &name[0];
-
-                CHECKED_CPX_CALL(CPXnewcols, env, lp, 1, &obj, &lb, &ub, &type, &cname);
+                type.push_back('B');
+                lb.push_back(0.0);
+                ub.push_back(1.0);
+                obj.push_back(inst.dist(i, j));
+                if (named) names.push_back("y_" + to_string(i) + "_" + to_string(j));
 
                 map_y[i][j] = position;
                 position++;
@@ -58,62 +87,44 @@ void TSPModel::setupLP(CEnv env, Prob lp) {
         }
     }
 
+    vector<char*> cnames;
+    for (string& s : names) cnames.push_back(&s[0]);
+    CHECKED_CPX_CALL(CPXnewcols, env, lp, position, &obj[0], &lb[0], &ub[0], &type[0], named ? &cnames[0] : NULL);
+
+    RowBlock rows;
+    // n + n + (n - 1) + (n - 1)^2 rows with 2n(n-1) + (n-1)(2n-3) + 2(n-1)^2 nonzeros
+    rows.ind.reserve(2 * (size_t)n * (n - 1) + 4 * (size_t)(n - 1) * (n - 1));
+    rows.val.reserve(rows.ind.capacity());
+
     // sum_j y_ij = 1   ∀ i ∈ N
     for (int i = 0; i < n; i++) {
-        vector<int> idx;
-        vector<double> coef;
+        rows.begin('E', 1.0);
         for (int j = 0; j < n; j++) {
-            if (i != j && map_y[i][j] >= 0) {
-                idx.push_back(map_y[i][j]);
-                coef.push_back(1.0);
-            }
+            if (i != j && map_y[i][j] >= 0) rows.add(map_y[i][j], 1.0);
         }
-        char sense = 'E'; // =
-        double rhs = 1.0;
-        int matbeg = 0;
-        CHECKED_CPX_CALL(CPXaddrows, env, lp, 0, 1, idx.size(), &rhs, &sense, &matbeg, &idx[0], &coef[0], NULL, NULL);
     }
 
     // sum_i y_ij = 1   ∀ j ∈ N
     for (int j = 0; j < n; j++) {
-        vector<int> idx;
-        vector<double> coef;
+        rows.begin('E', 1.0);
         for (int i = 0; i < n; i++) {
-            if (i != j && map_y[i][j] >= 0) {
-                idx.push_back(map_y[i][j]);
-                coef.push_back(1.0);
-            }
+            if (i != j && map_y[i][j] >= 0) rows.add(map_y[i][j], 1.0);
         }
-        char sense = 'E'; // =
-        double rhs = 1.0;
-        int matbeg = 0;
-        CHECKED_CPX_CALL(CPXaddrows, env, lp, 0, 1, idx.size(), &rhs, &sense, &matbeg, &idx[0], &coef[0], NULL, NULL);
     }
 
     // sum_i x_ik − sum_j x_kj = 1   ∀ k ∈ N \ {0}
     for (int k = 1; k < n; k++) {
-        vector<int> idx;
-        vector<double> coef;
+        rows.begin('E', 1.0);
 
         // incoming flow
         for (int i = 0; i < n; i++) {
-            if (map_x[i][k] >= 0) {
-                idx.push_back(map_x[i][k]);
-                coef.push_back(1.0);
-            }
+            if (map_x[i][k] >= 0) rows.add(map_x[i][k], 1.0);
         }
 
         // outgoing flow j != 0
         for (int j = 1; j < n; j++) {
-            if (map_x[k][j] >= 0) {
-                idx.push_back(map_x[k][j]);
-                coef.push_back(-1.0);
-            }
+            if (map_x[k][j] >= 0) rows.add(map_x[k][j], -1.0);
         }
-        char sense = 'E'; // =
-        double rhs = 1.0;
-        int matbeg = 0;
-        CHECKED_CPX_CALL(CPXaddrows, env, lp, 0, 1, idx.size(), &rhs, &sense, &matbeg, &idx[0], &coef[0], NULL, NULL);
     }
 
     // x_ij ≤ (n − 1) y_ij   ∀ i ≠ j, j ≠ 0
@@ -121,52 +132,103 @@ void TSPModel::setupLP(CEnv env, Prob lp) {
     for (int i = 0; i < n; i++) {
         for (int j = 1; j < n; j++) {
             if (i != j && map_x[i][j] >= 0 && map_y[i][j] >= 0) {
-                vector<int> idx(2);
-                vector<double> coef(2);
-
-                idx[0] = map_x[i][j];   // x_ij
-                coef[0] = 1.0;
-                idx[1] = map_y[i][j];   // y_ij
-                coef[1] = -(n - 1);
-
-                char sense = 'L'; // ≤
-                double rhs = 0.0;
-                int matbeg = 0;
-                CHECKED_CPX_CALL(CPXaddrows, env, lp, 0, 1, 2, &rhs, &sense, &matbeg, &idx[0], &coef[0], NULL, NULL);
+                rows.begin('L', 0.0);
+                rows.add(map_x[i][j], 1.0);         // x_ij
+                rows.add(map_y[i][j], -(n - 1));    // y_ij
             }
         }
     }
-    CHECKED_CPX_CALL(CPXwriteprob, env, lp, "tsp_CPX_CALL.lp", NULL);
+
+    // unnamed rows are written as c1, c2, ... in the LP file
+    int nrows = (int)rows.rhs.size();
+    CHECKED_CPX_CALL(CPXaddrows, env, lp, 0, nrows, (int)rows.ind.size(), &rows.rhs[0], &rows.sense[0], &rows.beg[0],
+                     &rows.ind[0], &rows.val[0], NULL, NULL);
+
+    if (named) {
+        CHECKED_CPX_CALL(CPXwriteprob, env, lp, lp_file.c_str(), NULL);
+    }
 }
 
-bool TSPModel::solve() {
-    DECL_ENV(env);
-    DECL_PROB(env, lp);
+void TSPModel::build() {
+    if (lp) return;
+    if (!env) {
+        DECL_ENV(new_env);
+        env = new_env;
+    }
+    DECL_PROB(env, new_lp);
+    lp = new_lp;
 
-    if (time_limit > 0.0){
-        CHECKED_CPX_CALL(CPXsetdblparam, env, CPX_PARAM_TILIM, time_limit);
+    double t1, t2;
+    CPXgettime(env, &t1);
+    try {
+        setupLP(env, lp);
+    } catch (...) {
+        // a half built model is not kept for the next call
+        CPXfreeprob(env, &lp);
+        throw;
     }
+    CPXgettime(env, &t2);
+    build_time = t2 - t1;
+}
+
+bool TSPModel::solve() {
+    build();
+    // nothing of an earlier call is reported if this one finds no solution
+    obj_value = 0.0;
+    gap = 0.0;
+    tour.clear();
+
+    // the search goes on from where the previous call stopped, so the time limit is the total over all the calls
+    // (the environment outlives the calls, the parameters of an earlier call are always overwritten)
+    double remaining = time_limit > 0.0 ? std::max(0.0, time_limit - solving_time) : 1e75;
+    CHECKED_CPX_CALL(CPXsetdblparam, env, CPX_PARAM_TILIM, remaining);
+    // nodes that cannot beat the starting tour are pruned from the start; the cutoff is a hair above its length so
+    // that the tour itself, when optimal, is still accepted as the incumbent
+    double cutoff = start_tour.empty() ? 1e75 : start_value + 1e-9 * std::max(1.0, start_value);
+    CHECKED_CPX_CALL(CPXsetdblparam, env, CPX_PARAM_CUTUP, cutoff);
+
+    // CPXmipopt resumes the branch and bound tree of the previous call as long as the model is not changed,
+    // so the MIP start goes in before the first call only
+    if (!searched && !start_tour.empty()) addMIPStart(env, lp);
+    searched = true;
 
-    setupLP(env, lp);
     double t1, t2;
     CPXgettime(env, &t1);
     CHECKED_CPX_CALL(CPXmipopt, env, lp);
     CPXgettime(env, &t2);
 
-    solving_time = t2 - t1;
+    solving_time += t2 - t1;
     lp_status = CPXgetstat(env, lp);
 
     if (lp_status == CPXMIP_OPTIMAL || lp_status == CPXMIP_OPTIMAL_TOL || lp_status == CPXMIP_TIME_LIM_FEAS){
         CHECKED_CPX_CALL(CPXgetobjval, env, lp, &obj_value);
+        CHECKED_CPX_CALL(CPXgetmiprelgap, env, lp, &gap);
         extractTour(env, lp);
     }
 
-    CPXfreeprob(env, &lp);
-    CPXcloseCPLEX(&env);
-
     return true;
 }
 
+// a complete solution: y = 1 on the edges of the tour, and the n - 1 units shipped from node 0 drop by one at
+// every node, so the k-th edge of the tour carries x = n - 1 - k (the edge back to node 0 has no x)
+void TSPModel::addMIPStart(CEnv env, Prob lp) {
+    int n = inst.n;
+    int ncols = CPXgetnumcols(env, lp);
+    vector<int> idx(ncols);
+    vector<double> vals(ncols, 0.0);
+    for (int j = 0; j < ncols; j++) idx[j] = j;
+
+    for (int k = 0; k < n; k++) {
+        int from = start_tour[k], to = start_tour[k + 1];
+        vals[map_y[from][to]] = 1.0;
+        if (to != 0) vals[map_x[from][to]] = n - 1 - k;
+    }
+
+    int beg = 0;
+    int effort = CPX_MIPSTART_CHECKFEAS;
+    CHECKED_CPX_CALL(CPXaddmipstarts, env, lp, 1, ncols, &beg, &idx[0], &vals[0], &effort, NULL);
+}
+
 void TSPModel::extractTour(CEnv env, Prob lp) {
     int ncols = CPXgetnumcols(env, lp);
     vector<double> vals(ncols);
@@ -221,6 +283,16 @@ double TSPModel::getSolvingTime() const
     return solving_time;
 }
 
+double TSPModel::getGap() const
+{
+    return gap;
+}
+
+double TSPModel::getBuildTime() const
+{
+    return build_time;
+}
+
 std::vector<int> TSPModel::getTour() const
 {
     return tour;
@@ -229,4 +301,25 @@ std::vector<int> TSPModel::getTour() const
 void TSPModel::setTimeLimit(double seconds)
 {
     time_limit = seconds;
+}
+
+void TSPModel::setLPFile(const std::string& filename)
+{
+    lp_file = filename;
+}
+
+void TSPModel::setStartTour(const std::vector<int>& closed_tour)
+{
+    if (!closed_tour.empty() && (int)closed_tour.size() != inst.n + 1) {
+        throw std::runtime_error("The starting tour must visit the " + std::to_string(inst.n) + " nodes once");
+    }
+    // the flow of the MIP start leaves from node 0: the tour is rotated to start there
+    start_tour = closed_tour;
+    if (!start_tour.empty()) {
+        start_tour.pop_back();
+        std::rotate(start_tour.begin(), std::find(start_tour.begin(), start_tour.end(), 0), start_tour.end());
+        start_tour.push_back(0);
+    }
+    start_value = 0.0;
+    for (size_t k = 0; k + 1 < start_tour.size(); k++) start_value += inst.dist(start_tour[k], start_tour[k + 1]);
 }
\ No newline at end of file
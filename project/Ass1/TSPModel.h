@@ -3,22 +3,41 @@
 
 #include "cpxmacro.h"
 #include "TSPInstance.h"
+#include <string>
 #include <vector>
 #include <ilcplex/cplex.h>
 
 //typedef CPXENVptr CEnv;
 //typedef CPXLPptr  Prob;
 
+// the CPLEX environment and the model are built once, by build() or the first solve(), and kept until the object is
+// destroyed: every solve() of the time ladder continues the branch and bound of the previous one
 class TSPModel {
 public:
     explicit TSPModel(const TSPInstance& instance);
+    ~TSPModel();
+    TSPModel(const TSPModel&) = delete;
+    TSPModel& operator=(const TSPModel&) = delete;
 
+    // total time of all the calls of solve(): a call stops once the solving time reaches it
     void setTimeLimit(double seconds);
+    // write the model, with named columns and rows, to this LP file once it is built; empty (default) = no file
+    void setLPFile(const std::string& filename);
+    // closed tour (first node repeated at the end) given to CPLEX as a MIP start, its length as the objective
+    // cutoff; an empty tour removes it. The MIP start is only used if set before the first solve()
+    void setStartTour(const std::vector<int>& closed_tour);
+    // open the environment and build the model, done by the first solve() if not called before
+    void build();
     bool solve();
 
     int getStatus() const;
     double getObjValue() const;
+    // relative gap between the incumbent and the best bound, 0 once it is proven optimal
+    double getGap() const;
+    // CPLEX time of all the calls of solve() so far
     double getSolvingTime() const;
+    // time spent building the model, not included in the solving time
+    double getBuildTime() const;
     std::vector<int> getTour() const;
 
 private:
@@ -27,15 +46,25 @@ private:
     std::vector<std::vector<int>> map_y;
     std::vector<std::vector<int>> map_x;
 
+    Env env;
+    Prob lp;
+
     int lp_status;
 
     double obj_value;
+    double gap;
     double solving_time;
+    double build_time;
     std::vector<int> tour;
 
     double time_limit;
+    std::string lp_file;
+    std::vector<int> start_tour;
+    double start_value;
+    bool searched = false;  // CPXmipopt already ran on the model
 
     void setupLP(CEnv env, Prob lp);
+    void addMIPStart(CEnv env, Prob lp);
     void extractTour(CEnv env, Prob lp);
 };
 
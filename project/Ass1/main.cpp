@@ -4,6 +4,7 @@
 #include <fstream>
 
 #include "TSPInstance.h"
+#include "TSPHeuristic.h"
 #include "TSPModel.h"
 #include "cpxmacro.h" 
 
@@ -11,8 +12,17 @@ namespace fs = std::filesystem;
 
 int main(int argc, char* argv[]) {
     std::string instance_filter = "all";
-    if (argc >= 2){
-        instance_filter = argv[1];   // e.g. "10", "20", "all"
+    std::string lp_file;    // -lp <file>: write the model of every instance, with names, to this file (debugging)
+    bool cold = false;      // -cold: no heuristic MIP start, CPLEX starts from nothing
+    for (int a = 1; a < argc; ++a) {
+        std::string arg = argv[a];
+        if (arg == "-lp" && a + 1 < argc) {
+            lp_file = argv[++a];
+        } else if (arg == "-cold") {
+            cold = true;
+        } else {
+            instance_filter = arg;   // e.g. "10", "20", "all"
+        }
     }
 
     // check for CPLEX
@@ -25,7 +35,8 @@ int main(int argc, char* argv[]) {
     }
 
     // the program will try to run the optimization with a certain time limit (first step, 1s)
-    // if no optimal solution is found up to this limit, then the time will be increased for the next iteration
+    // if no optimal solution is found up to this limit, then the time will be increased for the next iteration,
+    // which continues the search of the previous one: the limits are totals, 300s of search in all
     // at the end, if no optimal solution is found in 5 minutes, the program will continue with another data/sample
     std::vector<double> time_limits = {
         1, 10, 20, 30, 60, 90, 120, 180, 240, 300
@@ -43,7 +54,7 @@ int main(int argc, char* argv[]) {
         std::cerr << "Cannot open CSV file: " << csv_name << std::endl;
         return 1;
     }
-    csv << "instance,n,time_limit,status,obj_value,solving_time\n";
+    csv << "instance,n,time_limit,status,obj_value,solving_time,build_time,gap\n";
 
     // when this program is run, all data of our instance_filter are tested one by one
     for (const auto& entry : fs::directory_iterator(data_folder)) {
@@ -68,13 +79,38 @@ int main(int argc, char* argv[]) {
             continue;
         }
 
+        // the model is built once, every time limit resumes its branch and bound
+        TSPModel model(instance);
+        model.setLPFile(lp_file);
+        try {
+            model.build();
+        } catch (const std::exception& e) {
+            std::cerr << "Error building model: " << e.what() << std::endl;
+            continue;
+        }
+        std::cout << "  Model built in (sec) " << model.getBuildTime() << std::endl;
+
+        // the 2-opt + 3-opt tour of Ass2, a few milliseconds on these sizes, is the first incumbent of CPLEX
+        // and its length the cutoff of the branch and bound
+        if (!cold) {
+            try {
+                TSPHeuristic heuristic(instance);
+                heuristic.setThreeOpt(TSPHeuristic::ThreeOptMoves::Full);
+                heuristic.solve();
+                model.setStartTour(heuristic.getTour());
+                std::cout << "  Heuristic start with objValue " << heuristic.getObjValue() << " found in (sec) "
+                          << heuristic.getSolvingTime() << std::endl;
+            } catch (const std::exception& e) {
+                std::cerr << "Error in the heuristic start: " << e.what() << std::endl;
+            }
+        }
+
         bool solved_optimal = false;
 
         for (double tl : time_limits) {
 
             std::cout << "  Time limit: " << tl << "s" << std::endl;
 
-            TSPModel model(instance);
             model.setTimeLimit(tl);
 
             try {
@@ -106,7 +142,7 @@ int main(int argc, char* argv[]) {
                 status_str = "TIME_LIMIT";
                 std::cout << "  Time limit reached (feasible solution with objValue ";
                 std::cout << objValue;
-                std::cout << " )\n";
+                std::cout << ", gap " << 100.0 * model.getGap() << "% )\n";
             } else {
                 status_str = "NO_SOLUTION";
                 std::cout << "  No feasible solution\n";
@@ -127,7 +163,10 @@ int main(int argc, char* argv[]) {
                 << status_str << ","
                 << model.getObjValue() << ","
                 << model.getSolvingTime() << ","
-                << tour_str << "\n";
+                << model.getBuildTime() << ",";
+            // no gap without an incumbent
+            if (status_str != "NO_SOLUTION") csv << model.getGap();
+            csv << "," << tour_str << "\n";
             csv.flush();
 
             if (solved_optimal) break;
@@ -0,0 +1,16 @@
+#include "CostMatrix.h"
+
+CostMatrix::CostMatrix():n(0),stride(0),layout(Storage::Full) {}
+
+CostMatrix::CostMatrix(int n, Storage storage):n(n),stride(((std::size_t)n + 7) / 8 * 8),layout(storage) {
+    if (layout == Storage::Full) {
+        data.assign((std::size_t)n * stride, 0.0);
+    } else {
+        data.assign((std::size_t)n * (n + 1) / 2, 0.0);
+    }
+}
+
+void CostMatrix::set(int i, int j, double value) {
+    data[index(i, j)] = value;
+    if (layout == Storage::Full) data[index(j, i)] = value;
+}
@@ -0,0 +1,69 @@
+#ifndef COSTMATRIX_H
+#define COSTMATRIX_H
+
+#include <vector>
+#include <cstddef>
+#include <new>
+
+// allocator returning memory aligned to `Alignment` bytes (a cache line by default)
+template <class T, std::size_t Alignment = 64>
+struct AlignedAllocator {
+    using value_type = T;
+    template <class U> struct rebind { using other = AlignedAllocator<U, Alignment>; };
+
+    AlignedAllocator() = default;
+    template <class U> AlignedAllocator(const AlignedAllocator<U, Alignment>&) {}
+
+    T* allocate(std::size_t count) {
+        return static_cast<T*>(::operator new(count * sizeof(T), std::align_val_t(Alignment)));
+    }
+    void deallocate(T* p, std::size_t) {
+        ::operator delete(p, std::align_val_t(Alignment));
+    }
+    template <class U> bool operator==(const AlignedAllocator<U, Alignment>&) const { return true; }
+    template <class U> bool operator!=(const AlignedAllocator<U, Alignment>&) const { return false; }
+};
+
+// symmetric n x n cost matrix in a single contiguous, 64-byte aligned block
+// Full:   every row padded to a multiple of 8 doubles, so that each row starts on its own cache line
+// Packed: only the upper triangle (diagonal included), n(n+1)/2 entries, half the memory of Full
+class CostMatrix {
+public:
+    enum class Storage { Full, Packed };
+
+    CostMatrix();
+    explicit CostMatrix(int n, Storage storage = Storage::Full);
+
+    int size() const { return n; }
+    bool empty() const { return n == 0; }
+    Storage storage() const { return layout; }
+    std::size_t bytes() const { return data.size() * sizeof(double); }
+
+    double operator()(int i, int j) const { return data[index(i, j)]; }
+    // store the cost of both (i, j) and (j, i)
+    void set(int i, int j, double value);
+
+    // entry (i, i) in either storage, followed by the n-1-i entries (i, i+1) .. (i, n-1)
+    double* upperRow(int i) { return data.data() + index(i, i); }
+
+    // first entry of row i in full storage, the row holds n valid entries
+    double* row(int i) { return data.data() + (std::size_t)i * stride; }
+    const double* row(int i) const { return data.data() + (std::size_t)i * stride; }
+
+private:
+    int n;
+    std::size_t stride;     // doubles between the starts of two rows in full storage
+    Storage layout;
+    std::vector<double, AlignedAllocator<double>> data;
+
+    std::size_t index(int i, int j) const {
+        if (layout == Storage::Full) return (std::size_t)i * stride + j;
+        // branchless swap so that lo <= hi, random lookups would mispredict a branch half of the time
+        int lo = i < j ? i : j;
+        int hi = i < j ? j : i;
+        // rows 0..lo-1 of the upper triangle hold n + (n-1) + ... + (n-lo+1) entries
+        return (std::size_t)lo * n - (std::size_t)lo * (lo + 1) / 2 + hi;
+    }
+};
+
+#endif
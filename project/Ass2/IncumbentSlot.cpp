@@ -0,0 +1,79 @@
+#include "IncumbentSlot.h"
+
+IncumbentSlot::~IncumbentSlot() {
+    delete best.load();
+    for (Snapshot* s = retired.load(); s != nullptr;) {
+        Snapshot* next = s->next_retired;
+        delete s;
+        s = next;
+    }
+}
+
+// a reader registers before loading the pointer: once a snapshot is out of the slot and the count is 0,
+// nobody can still be looking at it
+bool IncumbentSlot::offer(double value, int owner, const std::vector<int>& tour) {
+    readers++;
+    Snapshot* current = best.load();
+    auto beats = [&](const Snapshot* s) {
+        return s == nullptr || value < s->value || (value == s->value && owner < s->owner);
+    };
+    if (!beats(current)) {
+        readers--;
+        return false;
+    }
+    Snapshot* mine = new Snapshot{value, owner, tour, nullptr};
+    while (!best.compare_exchange_weak(current, mine)) {
+        // someone else got in first: current holds the new incumbent
+        if (!beats(current)) {
+            readers--;
+            delete mine;
+            return false;
+        }
+    }
+    readers--;
+    if (current != nullptr) retire(current);
+    reclaim();
+    return true;
+}
+
+double IncumbentSlot::value() const {
+    readers++;
+    const Snapshot* current = best.load();
+    double v = current != nullptr ? current->value : std::numeric_limits<double>::infinity();
+    readers--;
+    return v;
+}
+
+std::vector<int> IncumbentSlot::tour() const {
+    readers++;
+    const Snapshot* current = best.load();
+    std::vector<int> t = current != nullptr ? current->tour : std::vector<int>();
+    readers--;
+    return t;
+}
+
+// lock-free stack of the replaced snapshots
+void IncumbentSlot::retire(Snapshot* s) {
+    s->next_retired = retired.load();
+    while (!retired.compare_exchange_weak(s->next_retired, s)) {
+    }
+}
+
+// take the whole retired stack and free it if nobody is reading, otherwise put it back
+void IncumbentSlot::reclaim() {
+    Snapshot* list = retired.exchange(nullptr);
+    if (list == nullptr) return;
+    if (readers.load() == 0) {
+        while (list != nullptr) {
+            Snapshot* next = list->next_retired;
+            delete list;
+            list = next;
+        }
+        return;
+    }
+    while (list != nullptr) {
+        Snapshot* next = list->next_retired;
+        retire(list);
+        list = next;
+    }
+}
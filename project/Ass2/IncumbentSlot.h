@@ -0,0 +1,44 @@
+#ifndef INCUMBENTSLOT_H
+#define INCUMBENTSLOT_H
+
+#include <atomic>
+#include <limits>
+#include <vector>
+
+// best tour found so far by a group of threads, shared without locks
+// the slot points to an immutable snapshot that is replaced with a compare-and-swap; a replaced snapshot is freed
+// only when no thread is reading any snapshot, otherwise it waits in a retired list for a later attempt
+class IncumbentSlot {
+public:
+    IncumbentSlot() = default;
+    ~IncumbentSlot();
+
+    IncumbentSlot(const IncumbentSlot&) = delete;
+    IncumbentSlot& operator=(const IncumbentSlot&) = delete;
+
+    // install the tour found by `owner` if it is shorter than the incumbent (equal values go to the lowest owner,
+    // so the final incumbent does not depend on the timing of the threads); true if installed
+    bool offer(double value, int owner, const std::vector<int>& tour);
+
+    // value of the incumbent, +infinity while the slot is empty
+    double value() const;
+    // copy of the incumbent tour, empty while the slot is empty
+    std::vector<int> tour() const;
+
+private:
+    struct Snapshot {
+        double value;
+        int owner;
+        std::vector<int> tour;
+        Snapshot* next_retired;
+    };
+
+    std::atomic<Snapshot*> best{nullptr};
+    mutable std::atomic<int> readers{0};
+    std::atomic<Snapshot*> retired{nullptr};
+
+    void retire(Snapshot* s);
+    void reclaim();
+};
+
+#endif
@@ -0,0 +1,47 @@
+#include "InstanceFile.h"
+#include <stdexcept>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+const char BINARY_MAGIC[8] = {'T', 'S', 'P', 'B', 'I', 'N', '1', '\0'};
+
+uint64_t fnv1a(const void* bytes, std::size_t count, uint64_t hash) {
+    const unsigned char* p = static_cast<const unsigned char*>(bytes);
+    for (std::size_t i = 0; i < count; ++i) {
+        hash ^= p[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+uint64_t contentHash(int n, const double* xs, const double* ys) {
+    uint64_t hash = fnv1a(&n, sizeof(n));
+    hash = fnv1a(xs, (std::size_t)n * sizeof(double), hash);
+    return fnv1a(ys, (std::size_t)n * sizeof(double), hash);
+}
+
+MappedFile::MappedFile(const std::string& filename) {
+    int fd = open(filename.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error("Cannot open file " + filename);
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0) {
+        close(fd);
+        throw std::runtime_error("Cannot read file " + filename);
+    }
+    length = (std::size_t)st.st_size;
+    void* p = mmap(nullptr, length, PROT_READ, MAP_SHARED, fd, 0);
+    // the mapping stays valid after the descriptor is closed
+    close(fd);
+    if (p == MAP_FAILED) {
+        throw std::runtime_error("Cannot map file " + filename);
+    }
+    base = static_cast<const char*>(p);
+}
+
+MappedFile::~MappedFile() {
+    munmap(const_cast<char*>(base), length);
+}
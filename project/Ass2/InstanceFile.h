@@ -0,0 +1,55 @@
+#ifndef INSTANCEFILE_H
+#define INSTANCEFILE_H
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+
+// binary instance file (.tspb), loaded by TSPInstance::readFromFile without any parsing:
+//   header              BinaryHeader, 64 bytes
+//   x coordinates       n doubles from byte xs_offset
+//   y coordinates       n doubles from byte ys_offset
+//   candidate lists     optional, n * k_neighbors ints from byte neighbors_offset, closest first
+// every block starts on a 64-byte boundary and numbers are stored in the byte order of the machine that wrote them.
+// The solver reads the coordinates and the lists in place from a read-only shared mapping, so processes solving
+// the same file share its pages in the page cache instead of each holding a copy
+struct BinaryHeader {
+    char magic[8];              // BINARY_MAGIC
+    int32_t n;
+    int32_t k_neighbors;        // 0 if the file has no candidate lists
+    int32_t quadrant;           // the lists were built with quadrant neighbors
+    int32_t metric;             // TSPInstance::Metric, 0 for the exact Euclidean distance
+    uint64_t content_hash;      // contentHash() of the coordinates
+    uint64_t xs_offset;
+    uint64_t ys_offset;
+    uint64_t neighbors_offset;
+    uint64_t file_size;
+};
+static_assert(sizeof(BinaryHeader) == 64, "the header fills one cache line");
+
+extern const char BINARY_MAGIC[8];
+
+// 64-bit FNV-1a of count bytes, continuing from hash
+const uint64_t FNV_OFFSET_BASIS = 14695981039346656037ULL;
+uint64_t fnv1a(const void* bytes, std::size_t count, uint64_t hash = FNV_OFFSET_BASIS);
+
+// FNV-1a over n and the bytes of the coordinates
+uint64_t contentHash(int n, const double* xs, const double* ys);
+
+// whole file mapped read-only, unmapped with the object
+class MappedFile {
+public:
+    explicit MappedFile(const std::string& filename);
+    ~MappedFile();
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    const char* data() const { return base; }
+    std::size_t size() const { return length; }
+
+private:
+    const char* base = nullptr;
+    std::size_t length = 0;
+};
+
+#endif
@@ -0,0 +1,136 @@
+#include "MatrixBuilder.h"
+#include "WorkStealingPool.h"
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <algorithm>
+#include <cmath>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define TSP_X86_KERNELS
+#endif
+
+// distances from (xi, yi) to the `count` nodes (xs[j], ys[j]), written to out[j]
+// no FMA is used anywhere: dx * dx + dy * dy must round exactly as in the scalar formula
+typedef void (*RowKernel)(double xi, double yi, const double* xs, const double* ys, double* out, int count);
+
+static void rowScalar(double xi, double yi, const double* xs, const double* ys, double* out, int count) {
+    for (int j = 0; j < count; ++j) {
+        double dx = xi - xs[j];
+        double dy = yi - ys[j];
+        out[j] = std::sqrt(dx * dx + dy * dy);
+    }
+}
+
+#ifdef TSP_X86_KERNELS
+__attribute__((target("avx2")))
+static void rowAvx2(double xi, double yi, const double* xs, const double* ys, double* out, int count) {
+    __m256d vx = _mm256_set1_pd(xi);
+    __m256d vy = _mm256_set1_pd(yi);
+    int j = 0;
+    for (; j + 4 <= count; j += 4) {
+        __m256d dx = _mm256_sub_pd(vx, _mm256_loadu_pd(xs + j));
+        __m256d dy = _mm256_sub_pd(vy, _mm256_loadu_pd(ys + j));
+        __m256d d2 = _mm256_add_pd(_mm256_mul_pd(dx, dx), _mm256_mul_pd(dy, dy));
+        _mm256_storeu_pd(out + j, _mm256_sqrt_pd(d2));
+    }
+    rowScalar(xi, yi, xs + j, ys + j, out + j, count - j);
+}
+
+// the headers of gcc 12 fill the unused result of _mm512_sqrt_pd with _mm512_undefined_pd(), a self-initialized
+// variable that -Wmaybe-uninitialized reports
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+__attribute__((target("avx512f")))
+static void rowAvx512(double xi, double yi, const double* xs, const double* ys, double* out, int count) {
+    __m512d vx = _mm512_set1_pd(xi);
+    __m512d vy = _mm512_set1_pd(yi);
+    int j = 0;
+    for (; j + 8 <= count; j += 8) {
+        __m512d dx = _mm512_sub_pd(vx, _mm512_loadu_pd(xs + j));
+        __m512d dy = _mm512_sub_pd(vy, _mm512_loadu_pd(ys + j));
+        __m512d d2 = _mm512_add_pd(_mm512_mul_pd(dx, dx), _mm512_mul_pd(dy, dy));
+        _mm512_storeu_pd(out + j, _mm512_sqrt_pd(d2));
+    }
+    rowScalar(xi, yi, xs + j, ys + j, out + j, count - j);
+}
+#pragma GCC diagnostic pop
+#endif
+
+static RowKernel selectKernel(const char** name) {
+#ifdef TSP_X86_KERNELS
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f")) {
+        *name = "avx512";
+        return rowAvx512;
+    }
+    if (__builtin_cpu_supports("avx2")) {
+        *name = "avx2";
+        return rowAvx2;
+    }
+#endif
+    *name = "scalar";
+    return rowScalar;
+}
+
+const char* distanceKernelName() {
+    const char* name;
+    selectKernel(&name);
+    return name;
+}
+
+// run work(item) for item = 0..count-1 on `threads` threads, items handed out in chunks through an atomic counter
+template <class F>
+static void parallelFor(int count, int threads, int chunk, F work) {
+    std::atomic<int> next(0);
+    auto worker = [&]() {
+        for (int begin = next.fetch_add(chunk); begin < count; begin = next.fetch_add(chunk)) {
+            int end = std::min(count, begin + chunk);
+            for (int item = begin; item < end; ++item) work(item);
+        }
+    };
+    std::vector<std::thread> pool;
+    for (int t = 1; t < threads; ++t) pool.emplace_back(worker);
+    worker();
+    for (auto& th : pool) th.join();
+}
+
+void buildCostMatrix(CostMatrix& cost, const double* xs, const double* ys, int threads) {
+    int n = cost.size();
+    const char* name;
+    RowKernel kernel = selectKernel(&name);
+
+    if (threads <= 0) {
+        threads = (int)std::max(1u, std::thread::hardware_concurrency());
+        // the workers of a pool solving other instances already use the cores: each one only gets its share
+        int pool_size = WorkStealingPool::currentPoolSize();
+        if (pool_size > 0) threads = std::max(1, threads / pool_size);
+    }
+    // small matrices are not worth starting threads for
+    threads = std::max(1, std::min(threads, n / 256));
+
+    // upper triangle: row i gets the distances to nodes i+1..n-1, stored right after the diagonal entry
+    parallelFor(n, threads, 16, [&](int i) {
+        kernel(xs[i], ys[i], xs + i + 1, ys + i + 1, cost.upperRow(i) + 1, n - i - 1);
+    });
+
+    if (cost.storage() == CostMatrix::Storage::Packed) return;
+
+    // full storage: copy the upper triangle into the lower one by square tiles, so that both the
+    // rows read and the rows written stay in cache
+    const int TILE = 64;
+    int tiles = (n + TILE - 1) / TILE;
+    parallelFor(tiles, threads, 1, [&](int bi) {
+        int i_end = std::min(n, (bi + 1) * TILE);
+        for (int bj = 0; bj <= bi; ++bj) {
+            int j_end = std::min(n, (bj + 1) * TILE);
+            for (int i = bi * TILE; i < i_end; ++i) {
+                double* row_i = cost.row(i);
+                for (int j = bj * TILE; j < j_end && j < i; ++j) {
+                    row_i[j] = cost.row(j)[i];
+                }
+            }
+        }
+    });
+}
@@ -0,0 +1,17 @@
+#ifndef MATRIXBUILDER_H
+#define MATRIXBUILDER_H
+
+#include "CostMatrix.h"
+
+// fill `cost` with the Euclidean distances between the n nodes (xs[i], ys[i])
+// rows of the upper triangle are computed by a vectorized kernel (AVX-512, AVX2 or scalar, chosen at runtime)
+// and split among `threads` threads (0 = all hardware threads, or its share of them when called from a worker of a
+// WorkStealingPool); each pair is computed once and, in full storage,
+// mirrored to the lower triangle tile by tile
+// values are bit-identical to the scalar std::sqrt(dx * dx + dy * dy)
+void buildCostMatrix(CostMatrix& cost, const double* xs, const double* ys, int threads = 0);
+
+// name of the kernel buildCostMatrix() uses on this machine: "avx512", "avx2" or "scalar"
+const char* distanceKernelName();
+
+#endif
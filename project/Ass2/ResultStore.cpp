@@ -0,0 +1,65 @@
+#include "ResultStore.h"
+#include <filesystem>
+#include <sstream>
+#include <iomanip>
+#include <stdexcept>
+
+namespace fs = std::filesystem;
+
+// a line is: hash,options,obj_value,solving_time,start_value,construction_time,<columns of the results csv>
+// the options never contain a comma
+ResultStore::ResultStore(const std::string& name):filename(name) {
+    std::ifstream fin(filename);
+    std::string line;
+    bool ends_with_newline = true;
+    std::streamoff complete_size = 0;    // up to the end of the last line with its newline
+    while (std::getline(fin, line)) {
+        ends_with_newline = !fin.eof();
+        if (ends_with_newline) complete_size = fin.tellg();
+        std::istringstream ss(line);
+        std::string hash, options, fields[4];
+        Record record;
+        std::getline(ss, hash, ',');
+        std::getline(ss, options, ',');
+        for (std::string& f : fields) std::getline(ss, f, ',');
+        std::getline(ss, record.columns);
+        // the last line of a run killed while writing it is incomplete
+        if (!ss || !ends_with_newline || record.columns.empty()) continue;
+        try {
+            record.obj_value = std::stod(fields[0]);
+            record.solving_time = std::stod(fields[1]);
+            record.start_value = std::stod(fields[2]);
+            record.construction_time = std::stod(fields[3]);
+        } catch (const std::exception&) {
+            continue;
+        }
+        records[hash + "," + options] = record;
+    }
+    fin.close();
+
+    // the incomplete line is dropped from the file: closed by a newline, it could read as a record next time
+    if (!ends_with_newline) fs::resize_file(filename, complete_size);
+    out.open(filename, std::ios::app);
+    if (!out.is_open()) {
+        throw std::runtime_error("Cannot open result store " + filename);
+    }
+}
+
+std::string ResultStore::key(uint64_t hash, const std::string& options) {
+    std::ostringstream ss;
+    ss << std::hex << std::setw(16) << std::setfill('0') << hash << "," << options;
+    return ss.str();
+}
+
+const ResultStore::Record* ResultStore::find(uint64_t hash, const std::string& options) const {
+    auto it = records.find(key(hash, options));
+    return it == records.end() ? nullptr : &it->second;
+}
+
+void ResultStore::add(uint64_t hash, const std::string& options, const Record& record) {
+    std::string k = key(hash, options);
+    records[k] = record;
+    out << k << "," << std::setprecision(17) << record.obj_value << "," << record.solving_time << ","
+        << record.start_value << "," << record.construction_time << "," << record.columns << "\n";
+    out.flush();
+}
@@ -0,0 +1,37 @@
+#ifndef RESULTSTORE_H
+#define RESULTSTORE_H
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <unordered_map>
+
+// results of earlier runs keyed by the content hash of the instance (TSPInstance::content_hash) and the solver
+// options, so that a run skips the instances it already solved with the same options, whatever their file name.
+// The store is an append-only file with one line per solved instance, written as soon as the instance is solved:
+// an interrupted run resumes where it stopped, and a later line for the same key replaces the earlier ones
+class ResultStore {
+public:
+    struct Record {
+        double obj_value = 0.0, solving_time = 0.0, start_value = 0.0, construction_time = 0.0;
+        std::string columns;    // the row of the results csv after the instance name
+    };
+
+    // the records already in the file, if it exists; new records are appended to it
+    explicit ResultStore(const std::string& filename);
+
+    // nullptr if the instance was never solved with these options; not thread safe, as add()
+    const Record* find(uint64_t hash, const std::string& options) const;
+    void add(uint64_t hash, const std::string& options, const Record& record);
+
+    int size() const { return (int)records.size(); }
+
+private:
+    std::string filename;
+    std::unordered_map<std::string, Record> records;
+    std::ofstream out;
+
+    static std::string key(uint64_t hash, const std::string& options);
+};
+
+#endif
@@ -0,0 +1,47 @@
+#ifndef SEARCHSTATS_H
+#define SEARCHSTATS_H
+
+#include <chrono>
+
+// counters of the local search, compiled in with -DTSP_STATS (the default of the makefile, `make STATS=0` drops it)
+// STATS(...) wraps every statement that updates them, so without the flag it expands to nothing and they stay 0
+#ifdef TSP_STATS
+#define STATS(...) __VA_ARGS__
+constexpr bool STATS_ENABLED = true;
+#else
+#define STATS(...)
+constexpr bool STATS_ENABLED = false;
+#endif
+
+// what one TSPHeuristic::solve() did, times in seconds
+struct SearchStats {
+    // moves scored and applied, calls of the pass functions, total length removed by the applied moves
+    long long two_opt_evaluated = 0;
+    long long two_opt_accepted = 0;
+    long long two_opt_passes = 0;
+    double two_opt_gain = 0.0;
+    double two_opt_time = 0.0;
+    // the phase of TSPAdvHeuristic.cpp, full 3-opt or Or-opt moves
+    long long three_opt_evaluated = 0;
+    long long three_opt_accepted = 0;
+    long long three_opt_passes = 0;
+    double three_opt_gain = 0.0;
+    double three_opt_time = 0.0;
+    double construction_time = 0.0;
+    // Tour::flip() calls and array entries they rewrote
+    long long reversals = 0;
+    long long moved_nodes = 0;
+};
+
+// adds the time spent in its scope to total
+class PhaseTimer {
+public:
+    explicit PhaseTimer(double& phase_total) : total(phase_total), start(std::chrono::steady_clock::now()) {}
+    ~PhaseTimer() { total += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count(); }
+
+private:
+    double& total;
+    std::chrono::steady_clock::time_point start;
+};
+
+#endif
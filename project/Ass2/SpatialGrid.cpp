@@ -0,0 +1,231 @@
+#include "SpatialGrid.h"
+#include <algorithm>
+#include <cmath>
+
+SpatialGrid::SpatialGrid(int n, const double* xs, const double* ys, double nodes_per_cell):n(n),xs(xs),ys(ys) {
+    // bounding box of the nodes
+    min_x = *std::min_element(xs, xs + n);
+    min_y = *std::min_element(ys, ys + n);
+    double w = *std::max_element(xs, xs + n) - min_x;
+    double h = *std::max_element(ys, ys + n) - min_y;
+
+    // square cells sized to hold about nodes_per_cell nodes each on uniform instances
+    double cells = std::max(1.0, n / nodes_per_cell);
+    cell = std::sqrt(std::max(w * h, 1e-12) / cells);
+    // degenerate boxes (all nodes on a line) would give too many cells along the long side
+    cell = std::max(cell, std::max(w, h) / cells);
+    if (cell <= 0.0) cell = 1.0;
+
+    cols = (int)(w / cell) + 1;
+    rows = (int)(h / cell) + 1;
+
+    // counting sort of the nodes into their cells
+    cell_start.assign((size_t)cols * rows + 1, 0);
+    for (int v = 0; v < n; ++v) {
+        cell_start[(size_t)row(ys[v]) * cols + column(xs[v]) + 1]++;
+    }
+    for (size_t c = 1; c < cell_start.size(); ++c) {
+        cell_start[c] += cell_start[c - 1];
+    }
+    cell_nodes.resize(n);
+    slot.resize(n);
+    cell_end.assign(cell_start.begin(), cell_start.end() - 1);
+    for (int v = 0; v < n; ++v) {
+        slot[v] = cell_end[(size_t)row(ys[v]) * cols + column(xs[v])]++;
+        cell_nodes[slot[v]] = v;
+    }
+}
+
+// swap v with the last node still in its cell and shrink the cell
+void SpatialGrid::remove(int v) {
+    size_t c = (size_t)row(ys[v]) * cols + column(xs[v]);
+    int last = --cell_end[c];
+    int u = cell_nodes[last];
+    std::swap(cell_nodes[slot[v]], cell_nodes[last]);
+    slot[u] = slot[v];
+    slot[v] = last;
+}
+
+int SpatialGrid::column(double x) const {
+    return std::min(cols - 1, std::max(0, (int)((x - min_x) / cell)));
+}
+
+int SpatialGrid::row(double y) const {
+    return std::min(rows - 1, std::max(0, (int)((y - min_y) / cell)));
+}
+
+double SpatialGrid::dist2(int i, int j) const {
+    double dx = xs[i] - xs[j];
+    double dy = ys[i] - ys[j];
+    return dx * dx + dy * dy;
+}
+
+template <class F>
+void SpatialGrid::forEachInRing(int cx, int cy, int r, F f) const {
+    auto visitCell = [&](int x, int y) {
+        if (x < 0 || x >= cols || y < 0 || y >= rows) return;
+        size_t c = (size_t)y * cols + x;
+        for (int p = cell_start[c]; p < cell_end[c]; ++p) f(cell_nodes[p]);
+    };
+    if (r == 0) {
+        visitCell(cx, cy);
+        return;
+    }
+    // top and bottom rows of the ring
+    for (int x = cx - r; x <= cx + r; ++x) {
+        visitCell(x, cy - r);
+        visitCell(x, cy + r);
+    }
+    // left and right columns, corners excluded
+    for (int y = cy - r + 1; y <= cy + r - 1; ++y) {
+        visitCell(cx - r, y);
+        visitCell(cx + r, y);
+    }
+}
+
+// the search visits rings of cells around node i: a node in ring r+1 is at least r * cell away,
+// so the search stops as soon as the k-th best distance found is within that bound
+std::vector<int> SpatialGrid::kNearest(int i, int k) const {
+    k = std::min(k, n - 1);
+    // max-heap of (squared distance, node) holding the best k nodes found so far
+    std::vector<std::pair<double, int>> heap;
+    heap.reserve(k + 1);
+
+    int cx = column(xs[i]), cy = row(ys[i]);
+    int max_r = std::max(std::max(cx, cols - 1 - cx), std::max(cy, rows - 1 - cy));
+
+    for (int r = 0; r <= max_r && k > 0; ++r) {
+        forEachInRing(cx, cy, r, [&](int v) {
+            if (v == i) return;
+            std::pair<double, int> cand(dist2(i, v), v);
+            if ((int)heap.size() < k) {
+                heap.push_back(cand);
+                std::push_heap(heap.begin(), heap.end());
+            } else if (cand < heap.front()) {
+                std::pop_heap(heap.begin(), heap.end());
+                heap.back() = cand;
+                std::push_heap(heap.begin(), heap.end());
+            }
+        });
+        double bound = r * cell;
+        if ((int)heap.size() == k && heap.front().first <= bound * bound) break;
+    }
+
+    std::sort_heap(heap.begin(), heap.end());
+    std::vector<int> result;
+    result.reserve(heap.size());
+    for (const auto& h : heap) result.push_back(h.second);
+    return result;
+}
+
+// ring search of kNearest() for k = 1
+// once most nodes are removed the rings around i are often empty and the search has to visit more of them
+int SpatialGrid::nearest(int i) const {
+    int best = -1;
+    double best_d2 = 0.0;
+
+    int cx = column(xs[i]), cy = row(ys[i]);
+    int max_r = std::max(std::max(cx, cols - 1 - cx), std::max(cy, rows - 1 - cy));
+
+    for (int r = 0; r <= max_r; ++r) {
+        forEachInRing(cx, cy, r, [&](int v) {
+            if (v == i) return;
+            double d2 = dist2(i, v);
+            if (best < 0 || d2 < best_d2 || (d2 == best_d2 && v < best)) {
+                best = v;
+                best_d2 = d2;
+            }
+        });
+        double bound = r * cell;
+        if (best >= 0 && best_d2 <= bound * bound) break;
+    }
+    return best;
+}
+
+// the nodes of ring r are at least (r - 1) * cell away from (x, y), so the search never goes past the radius
+int SpatialGrid::nearest(double x, double y, double radius) const {
+    int best = -1;
+    double best_d2 = radius * radius;
+
+    int cx = column(x), cy = row(y);
+    int max_r = std::max(std::max(cx, cols - 1 - cx), std::max(cy, rows - 1 - cy));
+    max_r = std::min(max_r, (int)std::min(radius / cell + 1.0, (double)max_r));
+
+    for (int r = 0; r <= max_r; ++r) {
+        forEachInRing(cx, cy, r, [&](int v) {
+            double dx = xs[v] - x;
+            double dy = ys[v] - y;
+            double d2 = dx * dx + dy * dy;
+            if (d2 < best_d2 || (d2 == best_d2 && (best < 0 || v < best))) {
+                best = v;
+                best_d2 = d2;
+            }
+        });
+        double bound = r * cell;
+        if (best >= 0 && best_d2 <= bound * bound) break;
+    }
+    return best;
+}
+
+// same ring search as kNearest(), with one bounded heap per quadrant besides the global one
+// quadrants with no nodes at all (i.e. nodes on the border of the board) make the search visit the whole grid,
+// which only happens for the few nodes on the convex hull
+std::vector<int> SpatialGrid::quadrantNearest(int i, int k) const {
+    k = std::min(k, n - 1);
+    int kq = std::max(1, k / 4);
+
+    using Entry = std::pair<double, int>;
+    std::vector<Entry> heaps[5];   // 0..3 the quadrants, 4 the global nearest
+    int limit[5] = {kq, kq, kq, kq, k};
+
+    auto offer = [&](std::vector<Entry>& heap, int cap, const Entry& cand) {
+        if ((int)heap.size() < cap) {
+            heap.push_back(cand);
+            std::push_heap(heap.begin(), heap.end());
+        } else if (cand < heap.front()) {
+            std::pop_heap(heap.begin(), heap.end());
+            heap.back() = cand;
+            std::push_heap(heap.begin(), heap.end());
+        }
+    };
+
+    int cx = column(xs[i]), cy = row(ys[i]);
+    int max_r = std::max(std::max(cx, cols - 1 - cx), std::max(cy, rows - 1 - cy));
+
+    for (int r = 0; r <= max_r && k > 0; ++r) {
+        forEachInRing(cx, cy, r, [&](int v) {
+            if (v == i) return;
+            double dx = xs[v] - xs[i];
+            double dy = ys[v] - ys[i];
+            int q = dx >= 0 ? (dy >= 0 ? 0 : 3) : (dy >= 0 ? 1 : 2);
+            Entry cand(dx * dx + dy * dy, v);
+            offer(heaps[q], limit[q], cand);
+            offer(heaps[4], limit[4], cand);
+        });
+        double bound = r * cell;
+        bool done = true;
+        for (int h = 0; h < 5; ++h) {
+            if ((int)heaps[h].size() < limit[h] || heaps[h].front().first > bound * bound) done = false;
+        }
+        if (done) break;
+    }
+
+    // quadrant neighbors first, then the remaining slots are filled with the globally nearest nodes
+    std::vector<Entry> picked;
+    picked.reserve(k);
+    for (int h = 0; h < 5; ++h) {
+        std::sort_heap(heaps[h].begin(), heaps[h].end());
+        for (const auto& e : heaps[h]) {
+            if ((int)picked.size() == k) break;
+            bool seen = false;
+            for (const auto& p : picked) seen = seen || p.second == e.second;
+            if (!seen) picked.push_back(e);
+        }
+    }
+    std::sort(picked.begin(), picked.end());
+
+    std::vector<int> result;
+    result.reserve(picked.size());
+    for (const auto& p : picked) result.push_back(p.second);
+    return result;
+}
@@ -0,0 +1,48 @@
+#ifndef SPATIALGRID_H
+#define SPATIALGRID_H
+
+#include <vector>
+
+// uniform bucket grid over the node coordinates, used to answer nearest neighbor queries
+// without looking at all the O(n^2) pairs of nodes
+class SpatialGrid {
+public:
+    SpatialGrid(int n, const double* xs, const double* ys, double nodes_per_cell = 2.0);
+
+    // the k nearest nodes to node i (i excluded), sorted by increasing distance
+    std::vector<int> kNearest(int i, int k) const;
+    // k nearest nodes to node i where, if available, at least k/4 of them are taken from each quadrant around i
+    // so that clustered instances still get candidate edges towards the other clusters
+    std::vector<int> quadrantNearest(int i, int k) const;
+    // the nearest node to node i (i excluded) still in the grid, -1 if there is none
+    int nearest(int i) const;
+    // the nearest node still in the grid within distance radius of point (x, y), -1 if there is none
+    int nearest(double x, double y, double radius) const;
+
+    // take node v out of the grid: it is no longer returned by the queries above
+    void remove(int v);
+
+private:
+    int n;
+    const double* xs;
+    const double* ys;
+
+    double min_x, min_y;
+    double cell;    // side of a cell
+    int cols, rows;
+
+    // the nodes of cell c are cell_nodes[cell_start[c] .. cell_end[c]), removed nodes are swapped past cell_end[c]
+    std::vector<int> cell_start;
+    std::vector<int> cell_end;
+    std::vector<int> cell_nodes;
+    std::vector<int> slot;      // slot[v] = index of node v in cell_nodes
+
+    int column(double x) const;
+    int row(double y) const;
+    double dist2(int i, int j) const;
+
+    // call f(v) for every node v in the cells at Chebyshev distance r from cell (cx, cy)
+    template <class F> void forEachInRing(int cx, int cy, int r, F f) const;
+};
+
+#endif
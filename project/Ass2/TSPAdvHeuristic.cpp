@@ -1,151 +1,156 @@
 #include "TSPHeuristic.h"
 #include <algorithm>
+#include <array>
 #include <numeric>
 #include <cmath>
 
-TSPHeuristic::TSPHeuristic(const TSPInstance& instance):inst(instance),n(instance.n),obj_value(0.0),solving_time(0.0) {}
-
-double TSPHeuristic::tourLength(const std::vector<int>& t) const {
-    double sum = 0.0;
-    for (size_t i = 0; i + 1 < t.size(); ++i) {
-        sum += inst.cost[t[i]][t[i + 1]];
+// 3-opt moves are accepted only if they shorten the tour by more than this amount:
+// the gain is a sum of six edges, so rounding must not let a move and its inverse both look improving
+static const double THREE_OPT_EPS = 1e-9;
+
+// a 3-opt move removes edges (tour[i-1], tour[i]), (tour[j-1], tour[j]), (tour[k-1], tour[k]) with i < j < k
+// and splits the tour into P = tour[0..i-1], A = tour[i..j-1], B = tour[j..k-1], C = tour[k..n]
+// the 7 possible reconnections are scored from the six affected edges only:
+//   (1) P + rev(A) + B + C           (5) P + rev(B) + rev(A) + C
+//   (2) P + A + rev(B) + C           (6) P + rev(B) + A + C
+//   (3) P + rev(A) + rev(B) + C      (7) P + B + rev(A) + C
+//   (4) P + B + A + C
+// (1), (2) and (5) are 2-opt moves, the others are pure 3-opt moves
+double TSPHeuristic::threeOptDelta(const TSPInstance& inst, const Tour& tour, int i, int j, int k, int move) {
+    int a = tour.node(i-1), b = tour.node(i);
+    int c = tour.node(j-1), d = tour.node(j);
+    int e = tour.node(k-1), f = tour.node(k);
+    auto w = [&](int a, int b) { return inst.dist(a, b); };
+
+    double removed = w(a, b) + w(c, d) + w(e, f);
+    double added = 0.0;
+    switch (move) {
+        case 1: added = w(a, c) + w(b, d) + w(e, f); break;
+        case 2: added = w(a, b) + w(c, e) + w(d, f); break;
+        case 3: added = w(a, c) + w(b, e) + w(d, f); break;
+        case 4: added = w(a, d) + w(e, b) + w(c, f); break;
+        case 5: added = w(a, e) + w(d, c) + w(b, f); break;
+        case 6: added = w(a, e) + w(d, b) + w(c, f); break;
+        case 7: added = w(a, d) + w(e, c) + w(b, f); break;
     }
-    return sum;
+    return added - removed;
 }
 
-// initialization of starting graph with Kruskal-like heuristic
-// add the shortest edges while avoiding early cycles enforcing degree <= 2 at each node, finally close the tour
-void TSPHeuristic::greedyInitialization() {
+double TSPHeuristic::threeOptDelta(int i, int j, int k, int move) const {
+    return threeOptDelta(inst, tour, i, j, k, move);
+}
 
-    // store edge with its weight
-    struct Edge {
-        int u, v;
-        double w;
+// rebuild the tour in place for the reconnection `move` of threeOptDelta(): only tour[i..k-1] is touched
+// every reconnection is a sequence of reversals, B + A being rev(rev(A) + rev(B))
+void TSPHeuristic::applyThreeOpt(int i, int j, int k, int move, double delta) {
+    // reverse tour[l..r-1], nothing for an empty range
+    auto rev = [&](int l, int r) {
+        if (r - l > 1) tour.reverse(l, r - 1);
     };
+    switch (move) {
+        case 1: rev(i, j); break;
+        case 2: rev(j, k); break;
+        case 3: rev(i, j); rev(j, k); break;
+        case 4: rev(i, j); rev(j, k); rev(i, k); break;
+        case 5: rev(i, k); break;
+        case 6: rev(i, j); rev(i, k); break;
+        case 7: rev(j, k); rev(i, k); break;
+    }
+    obj_value += delta;
+    STATS(stats.three_opt_accepted++; stats.three_opt_gain -= delta;)
+}
 
-    // generate all possible edges of the graph
-    std::vector<Edge> edges;
-    for (int i = 0; i < n; ++i)
-        for (int j = i + 1; j < n; ++j)
-            edges.push_back({i, j, inst.cost[i][j]});
+// index q of the tour edge (tour[q-1], tour[q]) joining the adjacent nodes x and y
+int TSPHeuristic::edgeIndex(int x, int y) const {
+    int px = std::min(tour.index(x), tour.index(y));
+    int py = std::max(tour.index(x), tour.index(y));
+    // the start node is at position 0 and its entering edge closes the tour at index n
+    return py - px == 1 ? py : n;
+}
 
-    // sort edges by increasing length
-    std::sort(edges.begin(), edges.end(), [](const Edge& a, const Edge& b) { return a.w < b.w; });
-    // degree of nodes in the partial solution
-    std::vector<int> degree(n, 0);
-    
-    // Union-Find structure to prevent cycles
-    std::vector<int> parent(n);
-    std::iota(parent.begin(), parent.end(), 0);
-    // Find operation
-    auto find = [&](int x) {
-        while (parent[x] != x)
-            x = parent[x] = parent[parent[x]];
-        return x;
+// sequential 3-opt move removing (t1,t2), (t3,t4), (t5,t6) and adding (t2,t3), (t4,t5), (t6,t1)
+// the move is applied only if it is one of the pure 3-opt reconnections, any other choice of
+// the six nodes would split the tour into subtours
+bool TSPHeuristic::trySequentialThreeOpt(const int t[6], double delta) {
+    int q[3] = {edgeIndex(t[0], t[1]), edgeIndex(t[2], t[3]), edgeIndex(t[4], t[5])};
+    std::sort(q, q + 3);
+    if (q[0] == q[1] || q[1] == q[2]) return false;
+    int i = q[0], j = q[1], k = q[2];
+    int a = tour.node(i-1), b = tour.node(i);
+    int c = tour.node(j-1), d = tour.node(j);
+    int e = tour.node(k-1), f = tour.node(k);
+
+    // edges as sorted node pairs, so that the added edges can be compared with each reconnection
+    using Edge = std::pair<int, int>;
+    auto edge = [](int x, int y) { return x < y ? Edge(x, y) : Edge(y, x); };
+    auto sorted = [](Edge e1, Edge e2, Edge e3) {
+        std::array<Edge, 3> s = {e1, e2, e3};
+        std::sort(s.begin(), s.end());
+        return s;
     };
-    // Union operation
-    auto unite = [&](int a, int b) {
-        a = find(a);
-        b = find(b);
-        if (a != b) parent[b] = a;
+    auto added = sorted(edge(t[1], t[2]), edge(t[3], t[4]), edge(t[5], t[0]));
+
+    const int moves[4] = {3, 4, 6, 7};
+    const std::array<Edge, 3> reconnections[4] = {
+        sorted(edge(a, c), edge(b, e), edge(d, f)),
+        sorted(edge(a, d), edge(e, b), edge(c, f)),
+        sorted(edge(a, e), edge(d, b), edge(c, f)),
+        sorted(edge(a, d), edge(e, c), edge(b, f))
     };
-
-    std::vector<std::pair<int,int>> selected;
-
-    for (const auto& e : edges) {
-        // check not exceed degree 2
-        if (degree[e.u] == 2 || degree[e.v] == 2) continue;
-        // avoid creating a cycle before having n-1 edges
-        if (find(e.u) == find(e.v) && selected.size() < n - 1) continue;
-
-        selected.emplace_back(e.u, e.v);
-        degree[e.u]++;
-        degree[e.v]++;
-        unite(e.u, e.v);
-
-        // stop when we have a Hamiltonian path (n-1 edges)
-        if (selected.size() == n - 1) break;
-    }
-
-    // search where to locate the last n-th edge to close the graph
-    std::vector<int> endpoints;
-    for (int i = 0; i < n; ++i)
-        if (degree[i] == 1)  endpoints.push_back(i);
-    // add the final edge
-    selected.emplace_back(endpoints[0], endpoints[1]);
-
-    // preparing adjacent list to reconstruct tour order
-    std::vector<std::vector<int>> adj(n);
-    for (auto& e : selected) {
-        adj[e.first].push_back(e.second);
-        adj[e.second].push_back(e.first);
-    }
-    // reconstruct tour
-    tour.clear();
-    tour.push_back(0);
-    int prev = -1, curr = 0;
-
-    while (true) {
-        int next;
-        // each node has two neighbors: choose the one not visited previously
-        if (adj[curr][0] != prev) {
-            next = adj[curr][0];
-        } else {
-            next = adj[curr][1];
+    for (int r = 0; r < 4; ++r) {
+        if (reconnections[r] == added) {
+            applyThreeOpt(i, j, k, moves[r], delta);
+            return true;
         }
-        // if we return to the start node 0, the tour is complete
-        if (next == tour[0]) break;
-        tour.push_back(next);
-        prev = curr;
-        curr = next;
     }
-    tour.push_back(tour[0]);
+    return false;
 }
 
-
-// iterated 2-opt with arcs sorted by their lenght
-// at each iteration, the longest edges of the current tour are considered first
-// the first improving 2-opt move is immediately accepted and another 2-opt iteration is started
-bool TSPHeuristic::twoOptLongEdgeFirst() {
-    bool improved = false;
-    int m = n;
-
-    // i corresponds to removing edge (tour[i-1], tour[i])
-    struct Cut {
-        int i;          // index of the cut
-        double length;  // length of the edge to be removed
-    };
-
-    // list of all edges of the current tour
-    std::vector<Cut> cuts;
-    for (int i = 1; i < m - 1; ++i) {
-        cuts.push_back({i, inst.cost[tour[i-1]][tour[i]]});
-    }
-    // sort edges in descending order of length
-    // for our heuristic long edges are tested first, as they are more likely to yield better improvements
-    std::sort(cuts.begin(), cuts.end(), [](const Cut& a, const Cut& b) { return a.length > b.length; });
-    // cost of the current tour
-    double best = tourLength(tour);
-    // try all 2-opt moves starting from the longest edges
-    for (const auto& c : cuts) {
-        // first cut position
-        int i = c.i;
-        // second cut position
-        for (int j = i + 1; j < m; ++j) {
-            // create a candidate tour by reversing the segment [i, j]
-            std::vector<int> candidate = tour;
-            std::reverse(candidate.begin() + i, candidate.begin() + j + 1);
-            // cost of th new tour
-            double cand_cost = tourLength(candidate);
-            if (cand_cost < best) {
-                tour = candidate;
-                improved = true;
-                return true;   // first improvement is accepted as new versione for the graph, another 2-opt iteration will be started
+// 3-opt moves starting from the cut edge (tour[i-1], tour[i]), in both orientations, driven by candidate lists:
+// each new edge must be on the candidate list of the node it leaves and keep the partial gain positive
+bool TSPHeuristic::threeOptCandidates(int i) {
+    auto w = [&](int a, int b) { return inst.dist(a, b); };
+    int kn = inst.k_neighbors;
+    auto succ = [&](int v) { return tour.next(v); };
+    auto pred = [&](int v) { return tour.prev(v); };
+
+    for (int dir = 0; dir < 2; ++dir) {
+        int t[6];
+        t[0] = dir == 0 ? tour.node(i-1) : tour.node(i);
+        t[1] = dir == 0 ? tour.node(i) : tour.node(i-1);
+        double removed1 = w(t[0], t[1]);
+
+        const int* n2 = inst.neighborsOf(t[1]);
+        for (int r2 = 0; r2 < kn; ++r2) {
+            t[2] = n2[r2];
+            double g1 = removed1 - w(t[1], t[2]);
+            if (g1 <= 0.0) break;
+
+            for (int t4 : {succ(t[2]), pred(t[2])}) {
+                t[3] = t4;
+                if (t[3] == t[1]) continue;
+                double g1r = g1 + w(t[2], t[3]);
+
+                const int* n4 = inst.neighborsOf(t[3]);
+                for (int r4 = 0; r4 < kn; ++r4) {
+                    t[4] = n4[r4];
+                    double g2 = g1r - w(t[3], t[4]);
+                    if (g2 <= 0.0) break;
+
+                    for (int t6 : {succ(t[4]), pred(t[4])}) {
+                        t[5] = t6;
+                        if (t[5] == t[0] || t[5] == t[3]) continue;
+                        double added = w(t[1], t[2]) + w(t[3], t[4]) + w(t[5], t[0]);
+                        double removed = removed1 + w(t[2], t[3]) + w(t[4], t[5]);
+                        double delta = added - removed;
+                        STATS(stats.three_opt_evaluated++;)
+                        if (delta < -THREE_OPT_EPS && trySequentialThreeOpt(t, delta)) return true;
+                    }
+                }
             }
         }
     }
-    // if a not improving 2-opt move is found, we return the previous iteration result
-    return improved;
+    return false;
 }
 
 // iterated 3-opt with arcs sorted by their lenght
@@ -153,9 +158,8 @@ bool TSPHeuristic::twoOptLongEdgeFirst() {
 // the first improving 3-opt move is immediately accepted and another 3-opt iteration is started
 // useful to escape the local optima of the 2-opt neighbourhood
 bool TSPHeuristic::threeOptLongEdgeFirst() {
+    STATS(PhaseTimer timer(stats.three_opt_time); stats.three_opt_passes++;)
     int m = n;
-    // cost of the current tour
-    double best = tourLength(tour);
 
     // i corresponds to removing edge (tour[i-1], tour[i])
     struct Cut {
@@ -163,121 +167,129 @@ bool TSPHeuristic::threeOptLongEdgeFirst() {
         double length;  // length of the edge to be removed
     };
 
+    // with candidate lists every edge of the tour can be cut, the full scan keeps its original range
+    int last_cut = inst.hasNeighborLists() ? m : m - 2;
+
     // list of all edges of the current tour
     std::vector<Cut> cuts;
-    for (int i = 1; i < m - 1; ++i) {
-        cuts.push_back({i, inst.cost[tour[i-1]][tour[i]]});
+    cuts.reserve(m);
+    for (int i = 1; i <= last_cut; ++i) {
+        cuts.push_back({i, inst.dist(tour.node(i-1), tour.node(i))});
     }
     // sort edges in descending order of length
     // for our heuristic long edges are tested first, as they are more likely to yield better improvements
     std::sort(cuts.begin(), cuts.end(), [](const Cut& a, const Cut& b) { return a.length > b.length; });
     // try all 3-opt moves starting from the longest edges
     for (const auto& c : cuts) {
+        if (outOfTime()) return false;
         // first cut position
         int i = c.i;
+        if (inst.hasNeighborLists()) {
+            if (threeOptCandidates(i)) return true;
+            continue;
+        }
         // second cut position
         for (int j = i + 1; j < m - 2; ++j) {
             // third cut position
             for (int k = j + 1; k < m - 1; ++k) {
-                // substring after 3 cuts
-                std::vector<int> P(tour.begin(), tour.begin() + i);
-                std::vector<int> A(tour.begin() + i, tour.begin() + j);
-                std::vector<int> B(tour.begin() + j, tour.begin() + k);
-                std::vector<int> C(tour.begin() + k, tour.end());
-                // candidate
-                std::vector<int> candidate;
-
-                // 7 possible moves for 3-opt
-                // (1) P + rev(A) + B + C
-                candidate = P;
-                candidate.insert(candidate.end(), A.rbegin(), A.rend());
-                candidate.insert(candidate.end(), B.begin(), B.end());
-                candidate.insert(candidate.end(), C.begin(), C.end());
-                if (tourLength(candidate) < best) { tour = candidate; return true; }
-
-                // (2) P + A + rev(B) + C
-                candidate = P;
-                candidate.insert(candidate.end(), A.begin(), A.end());
-                candidate.insert(candidate.end(), B.rbegin(), B.rend());
-                candidate.insert(candidate.end(), C.begin(), C.end());
-                if (tourLength(candidate) < best) { tour = candidate; return true; }
-
-                // (3) P + rev(A) + rev(B) + C
-                candidate = P;
-                candidate.insert(candidate.end(), A.rbegin(), A.rend());
-                candidate.insert(candidate.end(), B.rbegin(), B.rend());
-                candidate.insert(candidate.end(), C.begin(), C.end());
-                if (tourLength(candidate) < best) { tour = candidate; return true; }
-
-                // (4) P + B + A + C
-                candidate = P;
-                candidate.insert(candidate.end(), B.begin(), B.end());
-                candidate.insert(candidate.end(), A.begin(), A.end());
-                candidate.insert(candidate.end(), C.begin(), C.end());
-                if (tourLength(candidate) < best) { tour = candidate; return true; }
-
-                // (5) P + rev(B) + rev(A) + C
-                candidate = P;
-                candidate.insert(candidate.end(), B.rbegin(), B.rend());
-                candidate.insert(candidate.end(), A.rbegin(), A.rend());
-                candidate.insert(candidate.end(), C.begin(), C.end());
-                if (tourLength(candidate) < best) { tour = candidate; return true; }
-
-                // (6) P + rev(B) + A + C
-                candidate = P;
-                candidate.insert(candidate.end(), B.rbegin(), B.rend());
-                candidate.insert(candidate.end(), A.begin(), A.end());
-                candidate.insert(candidate.end(), C.begin(), C.end());
-                if (tourLength(candidate) < best) { tour = candidate; return true; }
-
-                // (7) P + B + rev(A) + C
-                candidate = P;
-                candidate.insert(candidate.end(), B.begin(), B.end());
-                candidate.insert(candidate.end(), A.rbegin(), A.rend());
-                candidate.insert(candidate.end(), C.begin(), C.end());
-                if (tourLength(candidate) < best) { tour = candidate; return true; }
+                if (outOfTime()) return false;
+                // 7 possible moves for 3-opt, scored in constant time and applied only when accepted
+                for (int move = 1; move <= 7; ++move) {
+                    double delta = threeOptDelta(i, j, k, move);
+                    STATS(stats.three_opt_evaluated++;)
+                    if (delta < -THREE_OPT_EPS) {
+                        applyThreeOpt(i, j, k, move, delta);
+                        return true;
+                    }
+                }
             }
         }
     }
     return false;
 }
 
-void TSPHeuristic::solve() {
-    auto start = std::chrono::high_resolution_clock::now();
-    greedyInitialization();
-
-    bool improved = true;
-
-    while (improved) {
-        improved = false;
-        while (twoOptLongEdgeFirst()) {
-            // twoOptLongEdgeFirst() is repeatedly called untill an improvement using a 2-opt is no more possible 
-            improved = true;
-        }
-        if (threeOptLongEdgeFirst()) {
-            // threeOptLongEdgeFirst() is repeatedly called untill an improvement using a 3-opt is no more possible 
-            improved = true;
-        }
-        // if at least one 3-opt move is performed, then it will retry with 2-opt local search
+// best reinsertion of the segment tour[s..e] between the nodes of edge q, in either orientation
+// the move is the 3-opt reconnection (4) for the same orientation and (6) or (7) for the reversed one
+bool TSPHeuristic::tryOrOptMove(int s, int e, int q) {
+    // edges s..e+1 touch the segment itself
+    if (q >= s && q <= e + 1) return false;
+
+    int i, j, k, reversed;
+    if (q < s) {
+        // the segment becomes B and moves back in front of A = tour[q..s-1]
+        i = q; j = s; k = e + 1; reversed = 6;
+    } else {
+        // the segment becomes A and moves after B = tour[e+1..q-1]
+        i = s; j = e + 1; k = q; reversed = 7;
     }
-
-    obj_value = tourLength(tour);
-    auto end = std::chrono::high_resolution_clock::now();
-    solving_time = std::chrono::duration<double>(end - start).count();
+    double forward_delta = threeOptDelta(i, j, k, 4);
+    double reversed_delta = threeOptDelta(i, j, k, reversed);
+    STATS(stats.three_opt_evaluated += 2;)
+    int move = forward_delta <= reversed_delta ? 4 : reversed;
+    double delta = std::min(forward_delta, reversed_delta);
+    if (delta >= -THREE_OPT_EPS) return false;
+
+    applyThreeOpt(i, j, k, move, delta);
+    return true;
 }
 
-
-double TSPHeuristic::getObjValue() const 
-{
-    return obj_value;
+// Or-opt: move a segment of 1 to 3 consecutive nodes next to the cut edge (tour[i-1], tour[i]) somewhere else
+// with candidate lists the segment is only reinserted next to candidates of its end nodes
+bool TSPHeuristic::orOptCandidates(int i) {
+    auto w = [&](int a, int b) { return inst.dist(a, b); };
+
+    for (int len = 1; len <= 3; ++len) {
+        // the segment starting right after the cut and the one ending right before it
+        for (int s : {i, i - len}) {
+            int e = s + len - 1;
+            // the start node at position 0 (and n) never moves
+            if (s < 1 || e > n - 1) continue;
+
+            int p = tour.node(s-1), u = tour.node(s), v = tour.node(e), nx = tour.node(e+1);
+            // length saved by taking the segment out and joining p to nx
+            double removal_gain = w(p, u) + w(v, nx) - w(p, nx);
+            if (removal_gain <= THREE_OPT_EPS) continue;
+
+            if (!inst.hasNeighborLists()) {
+                for (int q = 1; q <= n; ++q) {
+                    if (tryOrOptMove(s, e, q)) return true;
+                }
+                continue;
+            }
+            for (int end : {u, v}) {
+                const int* nl = inst.neighborsOf(end);
+                for (int r = 0; r < inst.k_neighbors; ++r) {
+                    int x = nl[r];
+                    // the new edge (end, x) alone must cost less than what the removal saved
+                    if (w(end, x) >= removal_gain) break;
+                    if (tour.index(x) >= s && tour.index(x) <= e) continue;
+                    // edges leaving and entering x
+                    if (tryOrOptMove(s, e, tour.index(x) + 1)) return true;
+                    if (tryOrOptMove(s, e, tour.index(x) == 0 ? n : tour.index(x))) return true;
+                }
+            }
+        }
+    }
+    return false;
 }
 
-double TSPHeuristic::getSolvingTime() const 
-{
-    return solving_time;
+// Or-opt pass with the long edges first, as the 2-opt and 3-opt ones: a much smaller neighborhood
+// than full 3-opt (segment moves only), so each pass costs O(n) moves with candidate lists
+bool TSPHeuristic::orOptLongEdgeFirst() {
+    STATS(PhaseTimer timer(stats.three_opt_time); stats.three_opt_passes++;)
+    struct Cut {
+        int i;
+        double length;
+    };
+    std::vector<Cut> cuts;
+    cuts.reserve(n);
+    for (int i = 1; i <= n; ++i) {
+        cuts.push_back({i, inst.dist(tour.node(i-1), tour.node(i))});
+    }
+    std::sort(cuts.begin(), cuts.end(), [](const Cut& a, const Cut& b) { return a.length > b.length; });
+    for (const auto& c : cuts) {
+        if (outOfTime()) return false;
+        if (orOptCandidates(c.i)) return true;
+    }
+    return false;
 }
-
-std::vector<int> TSPHeuristic::getTour() const 
-{
-    return tour;
-}
\ No newline at end of file
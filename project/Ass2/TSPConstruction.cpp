@@ -0,0 +1,377 @@
+#include "TSPConstruction.h"
+#include "SpatialGrid.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <numeric>
+#include <queue>
+#include <stdexcept>
+
+// store edge with its weight
+struct Edge {
+    int u, v;
+    double w;
+};
+
+// sort edges by increasing length, ties broken on the endpoints so that the result does not depend on the sort
+static void sortEdges(std::vector<Edge>& edges) {
+    std::sort(edges.begin(), edges.end(), [](const Edge& a, const Edge& b) {
+        if (a.w != b.w) return a.w < b.w;
+        return a.u != b.u ? a.u < b.u : a.v < b.v;
+    });
+}
+
+// partial solution of the greedy edge heuristic: a set of paths (fragments) covering all the nodes
+class Fragments {
+public:
+    explicit Fragments(int n):n(n),free_ends(n),degree(n, 0),parent(n),adj(2 * (size_t)n, -1) {
+        std::iota(parent.begin(), parent.end(), 0);
+    }
+
+    int edges() const { return selected; }
+    int endpoints() const { return free_ends; }
+    bool isEndpoint(int v) const { return degree[v] < 2; }
+
+    // Find operation of the Union-Find structure used to prevent cycles
+    int find(int x) {
+        while (parent[x] != x)
+            x = parent[x] = parent[parent[x]];
+        return x;
+    }
+
+    // add edge (u, v) unless it would exceed degree 2 or close a cycle
+    bool tryAdd(int u, int v) {
+        if (degree[u] == 2 || degree[v] == 2) return false;
+        int a = find(u), b = find(v);
+        if (a == b) return false;
+        parent[b] = a;
+        link(u, v);
+        selected++;
+        return true;
+    }
+
+    // scan the sorted edges until the fragments form a Hamiltonian path (n-1 edges)
+    void addGreedy(const std::vector<Edge>& sorted) {
+        for (const auto& e : sorted) {
+            if (selected == n - 1) break;
+            tryAdd(e.u, e.v);
+        }
+    }
+
+    // join the two endpoints of the Hamiltonian path and read the tour starting from node 0
+    std::vector<int> closeTour() {
+        std::vector<int> endpoints;
+        for (int i = 0; i < n; ++i)
+            if (degree[i] == 1) endpoints.push_back(i);
+        link(endpoints[0], endpoints[1]);
+
+        std::vector<int> tour;
+        tour.reserve(n + 1);
+        tour.push_back(0);
+        int prev = -1, curr = 0;
+        while (true) {
+            // each node has two neighbors: choose the one not visited previously
+            int next = adj[2 * curr] != prev ? adj[2 * curr] : adj[2 * curr + 1];
+            // if we return to the start node 0, the tour is complete
+            if (next == tour[0]) break;
+            tour.push_back(next);
+            prev = curr;
+            curr = next;
+        }
+        tour.push_back(tour[0]);
+        return tour;
+    }
+
+private:
+    int n;
+    int selected = 0;
+    int free_ends;          // nodes with degree < 2
+    std::vector<int> degree;
+    std::vector<int> parent;
+    std::vector<int> adj;   // the two neighbors of node v are adj[2v], adj[2v+1], -1 if missing
+
+    void link(int u, int v) {
+        adj[2 * u + degree[u]++] = v;
+        adj[2 * v + degree[v]++] = u;
+        free_ends -= (degree[u] == 2) + (degree[v] == 2);
+    }
+};
+
+// initialization of starting graph with Kruskal-like heuristic
+// add the shortest edges while avoiding early cycles enforcing degree <= 2 at each node, finally close the tour
+static std::vector<int> greedyTourAllEdges(const TSPInstance& inst) {
+    int n = inst.n;
+
+    // generate all possible edges of the graph
+    std::vector<Edge> edges;
+    edges.reserve((size_t)n * (n - 1) / 2);
+    for (int i = 0; i < n; ++i)
+        for (int j = i + 1; j < n; ++j)
+            edges.push_back({i, j, inst.dist(i, j)});
+
+    sortEdges(edges);
+    Fragments frag(n);
+    frag.addGreedy(edges);
+    return frag.closeTour();
+}
+
+std::vector<int> greedyTour(const TSPInstance& inst) {
+    // EXPLICIT weights are not distances in the plane of their coordinates, if there are any
+    if (inst.n <= GREEDY_ALL_EDGES_MAX_NODES || inst.metric == TSPInstance::Metric::Explicit) return greedyTourAllEdges(inst);
+    return greedyMatchingTour(inst);
+}
+
+// greedy matching in the style of Bentley: every fragment endpoint keeps a cursor on its list of nearest nodes
+// and a priority queue holds the edge to the current cursor of each endpoint, so the edges come out in the same
+// increasing order as in the full scan, but only the few closest ones of each node are ever generated.
+// Candidates that can no longer be used (interior node or same fragment) are skipped when the cursor moves,
+// and the endpoints that run out of candidates get their list widened, doubling its length each time.
+// frag may already hold some edges, the matching then only joins its fragments
+static void greedyMatching(const TSPInstance& inst, const SpatialGrid& grid, std::vector<std::vector<int>> nearest,
+                           Fragments& frag) {
+    int n = inst.n;
+    std::vector<int> cursor(n, 0);
+
+    // min-heap of candidate edges (length, endpoint, other node), ties broken on the nodes as in sortEdges()
+    struct Candidate {
+        double w;
+        int u, v;
+        bool operator>(const Candidate& o) const {
+            if (w != o.w) return w > o.w;
+            int a = std::min(u, v), b = std::min(o.u, o.v);
+            if (a != b) return a > b;
+            return std::max(u, v) > std::max(o.u, o.v);
+        }
+    };
+    std::priority_queue<Candidate, std::vector<Candidate>, std::greater<Candidate>> heap;
+
+    // the widened lists are searched among the endpoints only: an interior node is never a candidate again,
+    // so late in the scan a grid over all the nodes would mostly visit nodes to be skipped.
+    // The endpoint grid is rebuilt every time the number of endpoints halves
+    std::vector<int> ends(n), end_index(n);
+    std::vector<double> ex(inst.xs, inst.xs + n), ey(inst.ys, inst.ys + n);
+    std::iota(ends.begin(), ends.end(), 0);
+    std::iota(end_index.begin(), end_index.end(), 0);
+    SpatialGrid end_grid = grid;
+    // which build of the endpoint grid each list comes from, the initial lists count as build 0
+    int end_grid_id = 0;
+    std::vector<int> list_grid(n, 0);
+    auto rebuildEndGrid = [&]() {
+        ends.clear();
+        ex.clear();
+        ey.clear();
+        for (int v = 0; v < n; ++v) {
+            if (!frag.isEndpoint(v)) continue;
+            end_index[v] = (int)ends.size();
+            ends.push_back(v);
+            ex.push_back(inst.xs[v]);
+            ey.push_back(inst.ys[v]);
+        }
+        end_grid = SpatialGrid((int)ends.size(), ex.data(), ey.data());
+        end_grid_id++;
+    };
+
+    // move the cursor of endpoint u to its next usable candidate and queue that edge
+    // the candidates skipped or already tried can never become usable again, so a widened list is scanned from the start
+    auto advance = [&](int u) {
+        while (true) {
+            if (cursor[u] == (int)nearest[u].size()) {
+                if (2 * frag.endpoints() <= (int)ends.size()) rebuildEndGrid();
+                int width = (int)nearest[u].size();
+                // a list from the current grid that already holds all the endpoints: nothing left to join u to
+                if (list_grid[u] == end_grid_id && width >= (int)ends.size() - 1) return;
+                nearest[u] = end_grid.kNearest(end_index[u], std::max(2 * width, 2));
+                for (int& v : nearest[u]) v = ends[v];
+                list_grid[u] = end_grid_id;
+                cursor[u] = 0;
+            }
+            int v = nearest[u][cursor[u]];
+            if (frag.isEndpoint(v) && frag.find(u) != frag.find(v)) {
+                heap.push({inst.dist(u, v), u, v});
+                return;
+            }
+            cursor[u]++;
+        }
+    };
+    for (int u = 0; u < n; ++u) {
+        if (frag.isEndpoint(u)) advance(u);
+    }
+
+    // stop when we have a Hamiltonian path (n-1 edges)
+    while (frag.edges() < n - 1 && !heap.empty()) {
+        Candidate c = heap.top();
+        heap.pop();
+        if (!frag.isEndpoint(c.u)) continue;
+        frag.tryAdd(c.u, c.v);
+        if (frag.isEndpoint(c.u)) {
+            cursor[c.u]++;
+            advance(c.u);
+        }
+    }
+}
+
+// the k nearest nodes of each node, taken from the candidate lists of the instance when they are long enough
+static std::vector<std::vector<int>> nearestLists(const TSPInstance& inst, const SpatialGrid& grid, int k) {
+    std::vector<std::vector<int>> nearest(inst.n);
+    for (int i = 0; i < inst.n; ++i) {
+        if (inst.hasNeighborLists() && inst.k_neighbors >= k)
+            nearest[i].assign(inst.neighborsOf(i), inst.neighborsOf(i) + k);
+        else
+            nearest[i] = grid.kNearest(i, k);
+    }
+    return nearest;
+}
+
+std::vector<int> greedyMatchingTour(const TSPInstance& inst, int k) {
+    int n = inst.n;
+    if (n - 1 <= k) return greedyTourAllEdges(inst);
+
+    SpatialGrid grid(n, inst.xs, inst.ys);
+    Fragments frag(n);
+    greedyMatching(inst, grid, nearestLists(inst, grid, k), frag);
+    return frag.closeTour();
+}
+
+// tours built as an order of the nodes are rotated to start from node 0 and closed
+static std::vector<int> closeOrder(std::vector<int> order) {
+    std::rotate(order.begin(), std::find(order.begin(), order.end(), 0), order.end());
+    order.push_back(order[0]);
+    return order;
+}
+
+// position of the cell (x, y) along the Hilbert curve filling a 2^bits x 2^bits grid
+static uint64_t hilbertIndex(uint32_t x, uint32_t y, int bits) {
+    uint32_t side = 1u << bits;
+    uint64_t d = 0;
+    for (uint32_t s = side / 2; s > 0; s /= 2) {
+        uint32_t rx = (x & s) > 0;
+        uint32_t ry = (y & s) > 0;
+        d += (uint64_t)s * s * ((3 * rx) ^ ry);
+        // rotate the quadrant so that the curve inside it has the standard orientation
+        if (ry == 0) {
+            if (rx == 1) {
+                x = side - 1 - x;
+                y = side - 1 - y;
+            }
+            std::swap(x, y);
+        }
+    }
+    return d;
+}
+
+// visit the nodes in the order of a Hilbert curve over the bounding square of the instance
+// nearby nodes along the curve are close in the plane: a much longer start than the greedy one, but built in a single sort
+std::vector<int> spaceFillingCurveTour(const TSPInstance& inst) {
+    int n = inst.n;
+    const int BITS = 16;
+    double min_x = *std::min_element(inst.xs, inst.xs + n);
+    double min_y = *std::min_element(inst.ys, inst.ys + n);
+    double span = std::max(*std::max_element(inst.xs, inst.xs + n) - min_x,
+                           *std::max_element(inst.ys, inst.ys + n) - min_y);
+    double scale = span > 0.0 ? ((1u << BITS) - 1) / span : 0.0;
+
+    std::vector<std::pair<uint64_t, int>> keys(n);
+    for (int v = 0; v < n; ++v) {
+        uint32_t x = (uint32_t)((inst.xs[v] - min_x) * scale);
+        uint32_t y = (uint32_t)((inst.ys[v] - min_y) * scale);
+        keys[v] = {hilbertIndex(x, y, BITS), v};
+    }
+    std::sort(keys.begin(), keys.end());
+
+    std::vector<int> order(n);
+    for (int i = 0; i < n; ++i) order[i] = keys[i].second;
+    return closeOrder(order);
+}
+
+// from node 0 always move to the closest node not visited yet, found in the grid the visited nodes are removed from
+std::vector<int> nearestNeighborTour(const TSPInstance& inst) {
+    int n = inst.n;
+    SpatialGrid grid(n, inst.xs, inst.ys);
+
+    std::vector<int> tour;
+    tour.reserve(n + 1);
+    int curr = 0;
+    tour.push_back(curr);
+    grid.remove(curr);
+    for (int step = 1; step < n; ++step) {
+        curr = grid.nearest(curr);
+        tour.push_back(curr);
+        grid.remove(curr);
+    }
+    tour.push_back(tour[0]);
+    return tour;
+}
+
+// Clarke-Wright savings: every node starts on its own round trip from a central hub, and two trips are merged
+// through the edge (u, v) saving the most, d(hub, u) + d(hub, v) - d(u, v), while degree <= 2 and no cycle.
+// Only the candidate edges of the k nearest nodes are scored; the hub and the fragments left are then joined
+// by the greedy matching
+std::vector<int> savingsTour(const TSPInstance& inst, int k) {
+    int n = inst.n;
+    if (n < 4) return greedyTourAllEdges(inst);
+    SpatialGrid grid(n, inst.xs, inst.ys);
+    std::vector<std::vector<int>> nearest = nearestLists(inst, grid, k);
+
+    // hub: the node closest to the center of mass
+    double cx = 0.0, cy = 0.0;
+    for (int v = 0; v < n; ++v) {
+        cx += inst.xs[v];
+        cy += inst.ys[v];
+    }
+    cx /= n;
+    cy /= n;
+    int hub = 0;
+    double best = INFINITY;
+    for (int v = 0; v < n; ++v) {
+        double d = (inst.xs[v] - cx) * (inst.xs[v] - cx) + (inst.ys[v] - cy) * (inst.ys[v] - cy);
+        if (d < best) {
+            best = d;
+            hub = v;
+        }
+    }
+
+    // candidate edges with their saving stored as a negative weight, so that sortEdges() puts the best first
+    std::vector<Edge> edges;
+    edges.reserve((size_t)n * k);
+    for (int u = 0; u < n; ++u) {
+        if (u == hub) continue;
+        for (int v : nearest[u]) {
+            if (v == hub || (v < u && std::find(nearest[v].begin(), nearest[v].end(), u) != nearest[v].end())) continue;
+            double saving = inst.dist(hub, u) + inst.dist(hub, v) - inst.dist(u, v);
+            edges.push_back({std::min(u, v), std::max(u, v), -saving});
+        }
+    }
+    sortEdges(edges);
+
+    Fragments frag(n);
+    for (const auto& e : edges) {
+        // a Hamiltonian path of the nodes other than the hub
+        if (frag.edges() == n - 2) break;
+        frag.tryAdd(e.u, e.v);
+    }
+    greedyMatching(inst, grid, std::move(nearest), frag);
+    return frag.closeTour();
+}
+
+std::vector<int> buildTour(const TSPInstance& inst, Construction method) {
+    if (method != Construction::Greedy && !inst.hasCoordinates()) {
+        throw std::runtime_error(std::string("The ") + constructionName(method) + " start needs node coordinates");
+    }
+    switch (method) {
+        case Construction::SpaceFillingCurve: return spaceFillingCurveTour(inst);
+        case Construction::NearestNeighbor: return nearestNeighborTour(inst);
+        case Construction::Savings: return savingsTour(inst);
+        case Construction::Greedy: break;
+    }
+    return greedyTour(inst);
+}
+
+const char* constructionName(Construction method) {
+    switch (method) {
+        case Construction::SpaceFillingCurve: return "curve";
+        case Construction::NearestNeighbor: return "nn";
+        case Construction::Savings: return "savings";
+        case Construction::Greedy: break;
+    }
+    return "greedy";
+}
@@ -0,0 +1,40 @@
+#ifndef TSPCONSTRUCTION_H
+#define TSPCONSTRUCTION_H
+
+#include "TSPInstance.h"
+#include <vector>
+
+// construction heuristics shared by the solvers
+// tours are returned as the sequence of visited nodes starting from node 0, with node 0 repeated at the end
+
+// up to this size the greedy heuristic sorts all the n(n-1)/2 edges, above it only candidate edges
+const int GREEDY_ALL_EDGES_MAX_NODES = 1000;
+
+// Kruskal-like greedy edge heuristic: shortest edges first, keeping degree <= 2 and avoiding early cycles
+std::vector<int> greedyTour(const TSPInstance& inst);
+
+// same greedy edge heuristic driven by nearest neighbor searches from the fragment endpoints, starting from the
+// k nearest nodes of each node: near-linear time and O(n k) memory instead of the O(n^2) sorted edge list
+std::vector<int> greedyMatchingTour(const TSPInstance& inst, int k = 10);
+
+// nodes in the order of a Hilbert space-filling curve: O(n log n), the cheapest start
+std::vector<int> spaceFillingCurveTour(const TSPInstance& inst);
+
+// nearest neighbor tour from node 0, with the unvisited nodes kept in a grid
+std::vector<int> nearestNeighborTour(const TSPInstance& inst);
+
+// Clarke-Wright savings around a central hub, scored on the edges towards the k nearest nodes
+std::vector<int> savingsTour(const TSPInstance& inst, int k = 10);
+
+// the starting tours the solvers can be asked for
+enum class Construction {
+    Greedy,             // greedyTour()
+    SpaceFillingCurve,  // spaceFillingCurveTour()
+    NearestNeighbor,    // nearestNeighborTour()
+    Savings             // savingsTour()
+};
+std::vector<int> buildTour(const TSPInstance& inst, Construction method);
+// short name used on the command line and in the reports
+const char* constructionName(Construction method);
+
+#endif
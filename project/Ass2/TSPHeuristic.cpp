@@ -2,112 +2,114 @@
 #include <algorithm>
 #include <numeric>
 #include <cmath>
+#include <deque>
+#include <utility>
 
-TSPHeuristic::TSPHeuristic(const TSPInstance& instance):inst(instance),n(instance.n),obj_value(0.0),solving_time(0.0) {}
+TSPHeuristic::TSPHeuristic(const TSPInstance& instance):inst(instance),n(instance.n),obj_value(0.0),solving_time(0.0),two_opt_strategy(TwoOptStrategy::LongEdgeFirst),three_opt(ThreeOptMoves::None),construction(Construction::Greedy),start_value(0.0),construction_time(0.0) {}
 
-double TSPHeuristic::tourLength(const std::vector<int>& t) const {
+// true once the deadline has passed
+bool TSPHeuristic::deadlinePassed() {
+    if (has_deadline && !time_limit_reached) time_limit_reached = std::chrono::steady_clock::now() >= deadline;
+    return time_limit_reached;
+}
+
+// the same check inside the move loops, where the clock is read only once every 256 calls:
+// a call costs far less than a clock read with candidate lists
+bool TSPHeuristic::outOfTime() {
+    if (time_limit_reached) return true;
+    if (!has_deadline || (++time_checks & 255) != 0) return false;
+    return deadlinePassed();
+}
+
+void TSPHeuristic::reportIncumbent() const {
+    if (!incumbent_callback) return;
+    incumbent_callback(std::chrono::duration<double>(std::chrono::steady_clock::now() - solve_start).count(), obj_value);
+}
+
+// edges summed from node 0 in the order of the tour
+double TSPHeuristic::tourLength() const {
     double sum = 0.0;
-    for (size_t i = 0; i + 1 < t.size(); ++i) {
-        sum += inst.cost[t[i]][t[i + 1]];
+    for (int i = 0; i < n; ++i) {
+        sum += inst.dist(tour.node(i), tour.node(i + 1));
     }
     return sum;
 }
 
-// initialization of starting graph with Kruskal-like heuristic
-// add the shortest edges while avoiding early cycles enforcing degree <= 2 at each node, finally close the tour
-void TSPHeuristic::greedyInitialization() {
+// length of the tour traversed backwards, summed in the same order tourLength() would use on the reversed tour
+double TSPHeuristic::reversedTourLength() const {
+    double sum = 0.0;
+    for (int i = n; i > 0; --i) {
+        sum += inst.dist(tour.node(i), tour.node(i - 1));
+    }
+    return sum;
+}
 
-    // store edge with its weight
-    struct Edge {
-        int u, v;
-        double w;
-    };
+// initialization of starting graph with the chosen heuristic of TSPConstruction.cpp (Kruskal-like by default)
+void TSPHeuristic::initialization() {
+    tour = Tour(start_tour.empty() ? buildTour(inst, construction) : start_tour);
+}
 
-    // generate all possible edges of the graph
-    std::vector<Edge> edges;
-    for (int i = 0; i < n; ++i)
-        for (int j = i + 1; j < n; ++j)
-            edges.push_back({i, j, inst.cost[i][j]});
-
-    // sort edges by increasing length
-    std::sort(edges.begin(), edges.end(), [](const Edge& a, const Edge& b) { return a.w < b.w; });
-    // degree of nodes in the partial solution
-    std::vector<int> degree(n, 0);
-    
-    // Union-Find structure to prevent cycles
-    std::vector<int> parent(n);
-    std::iota(parent.begin(), parent.end(), 0);
-    // Find operation
-    auto find = [&](int x) {
-        while (parent[x] != x)
-            x = parent[x] = parent[parent[x]];
-        return x;
-    };
-    // Union operation
-    auto unite = [&](int a, int b) {
-        a = find(a);
-        b = find(b);
-        if (a != b) parent[b] = a;
-    };
 
-    std::vector<std::pair<int,int>> selected;
+// change in tour length caused by reversing the segment [i, j]
+// only the two removed edges (tour[i-1], tour[i]), (tour[j], tour[j+1]) and the two added ones
+// (tour[i-1], tour[j]), (tour[i], tour[j+1]) are involved, so the move is scored in constant time
+double TSPHeuristic::twoOptDelta(const TSPInstance& inst, const Tour& tour, int i, int j) {
+    int a = tour.node(i - 1), b = tour.node(i);
+    int c = tour.node(j), d = tour.node(j + 1);
+    double added = inst.dist(a, c) + inst.dist(b, d);
+    double removed = inst.dist(a, b) + inst.dist(c, d);
+    return added - removed;
+}
 
-    for (const auto& e : edges) {
-        // check not exceed degree 2
-        if (degree[e.u] == 2 || degree[e.v] == 2) continue;
-        // avoid creating a cycle before having n-1 edges
-        if (find(e.u) == find(e.v) && selected.size() < n - 1) continue;
+double TSPHeuristic::twoOptDelta(int i, int j) const {
+    return twoOptDelta(inst, tour, i, j);
+}
 
-        selected.emplace_back(e.u, e.v);
-        degree[e.u]++;
-        degree[e.v]++;
-        unite(e.u, e.v);
+// 2-opt move removing edges (tour[p-1], tour[p]) and (tour[q-1], tour[q]), applied only if it shortens the tour
+bool TSPHeuristic::tryTwoOpt(int p, int q) {
+    if (p > q) std::swap(p, q);
+    // adjacent edges share a node and cannot be exchanged
+    if (q - p < 2) return false;
+    double delta = twoOptDelta(p, q - 1);
+    STATS(stats.two_opt_evaluated++;)
+    if (delta >= 0.0) return false;
+    tour.reverse(p, q - 1);
+    obj_value += delta;
+    STATS(stats.two_opt_accepted++; stats.two_opt_gain -= delta;)
+    return true;
+}
 
-        // stop when we have a Hamiltonian path (n-1 edges)
-        if (selected.size() == n - 1) break;
-    }
+// 2-opt moves removing edge (a, b) = (tour[i-1], tour[i]) whose new edge at a or at b is on a candidate list
+// candidates are sorted by distance, so the scan stops at the first one not shorter than the removed edge:
+// an improving move always has a new edge shorter than the removed edge next to it
+bool TSPHeuristic::twoOptCandidates(int i) {
+    int a = tour.node(i - 1), b = tour.node(i);
+    int k = inst.k_neighbors;
+    double removed = inst.dist(a, b);
 
-    // search where to locate the last n-th edge to close the graph
-    std::vector<int> endpoints;
-    for (int i = 0; i < n; ++i)
-        if (degree[i] == 1)  endpoints.push_back(i);
-    // add the final edge
-    selected.emplace_back(endpoints[0], endpoints[1]);
-
-    // preparing adjacent list to reconstruct tour order
-    std::vector<std::vector<int>> adj(n);
-    for (auto& e : selected) {
-        adj[e.first].push_back(e.second);
-        adj[e.second].push_back(e.first);
+    const int* na = inst.neighborsOf(a);
+    for (int r = 0; r < k; ++r) {
+        int c = na[r];
+        if (inst.dist(a, c) >= removed) break;
+        // new edge (a, c): the other removed edge is the one leaving c
+        if (tryTwoOpt(i, tour.index(c) + 1)) return true;
     }
-    // reconstruct tour
-    tour.clear();
-    tour.push_back(0);
-    int prev = -1, curr = 0;
-
-    while (true) {
-        int next;
-        // each node has two neighbors: choose the one not visited previously
-        if (adj[curr][0] != prev) {
-            next = adj[curr][0];
-        } else {
-            next = adj[curr][1];
-        }
-        // if we return to the start node 0, the tour is complete
-        if (next == tour[0]) break;
-        tour.push_back(next);
-        prev = curr;
-        curr = next;
+
+    const int* nb = inst.neighborsOf(b);
+    for (int r = 0; r < k; ++r) {
+        int c = nb[r];
+        if (inst.dist(b, c) >= removed) break;
+        // new edge (b, c): the other removed edge is the one entering c (the start node is entered at position n)
+        if (tryTwoOpt(i, tour.index(c) == 0 ? n : tour.index(c))) return true;
     }
-    tour.push_back(tour[0]);
+    return false;
 }
 
-
 // iterated 2-opt with arcs sorted by their lenght
-// tt each iteration, the longest edges of the current tour are considered first
+// at each iteration, the longest edges of the current tour are considered first
 // the first improving 2-opt move is immediately accepted and another 2-opt iteration is started
 bool TSPHeuristic::twoOptLongEdgeFirst() {
-    bool improved = false;
+    STATS(PhaseTimer timer(stats.two_opt_time); stats.two_opt_passes++;)
     int m = n;
 
     // i corresponds to removing edge (tour[i-1], tour[i])
@@ -116,51 +118,194 @@ bool TSPHeuristic::twoOptLongEdgeFirst() {
         double length;  // length of the edge to be removed
     };
 
+    // with candidate lists every edge of the tour can be cut, the full scan keeps its original range
+    int last_cut = inst.hasNeighborLists() ? m : m - 2;
+
     // list of all edges of the current tour
     std::vector<Cut> cuts;
-    for (int i = 1; i < m - 1; ++i) {
-        cuts.push_back({i, inst.cost[tour[i-1]][tour[i]]});
+    cuts.reserve(m);
+    for (int i = 1; i <= last_cut; ++i) {
+        cuts.push_back({i, inst.dist(tour.node(i-1), tour.node(i))});
     }
     // sort edges in descending order of length
     // for our heuristic long edges are tested first, as they are more likely to yield better improvements
     std::sort(cuts.begin(), cuts.end(), [](const Cut& a, const Cut& b) { return a.length > b.length; });
-    // cost of the current tour
-    double best = tourLength(tour);
     // try all 2-opt moves starting from the longest edges
     for (const auto& c : cuts) {
+        if (outOfTime()) return false;
         // first cut position
         int i = c.i;
+        // with candidate lists only O(k) second cuts are tried instead of O(n)
+        if (inst.hasNeighborLists()) {
+            if (twoOptCandidates(i)) return true;
+            continue;
+        }
         // second cut position
         for (int j = i + 1; j < m; ++j) {
-            // create a candidate tour by reversing the segment [i, j]
-            std::vector<int> candidate = tour;
-            std::reverse(candidate.begin() + i, candidate.begin() + j + 1);
-            // cost of th new tour
-            double cand_cost = tourLength(candidate);
-            if (cand_cost < best) {
-                tour = candidate;
-                improved = true;
+            if (outOfTime()) return false;
+            // reversing the segment [i, j] shortens the tour only if the new edges are shorter than the removed ones
+            double delta = twoOptDelta(i, j);
+            STATS(stats.two_opt_evaluated++;)
+            bool accepted = delta < 0.0;
+            if (i == 1 && j == m - 1) {
+                // reversing [1, n-1] only flips the orientation of the tour (delta is exactly 0), but comparing full
+                // tour lengths used to accept it whenever rounding made the reversed sum look shorter
+                // the two sums are kept for this single move so that results stay identical to the copy-based version,
+                // it costs O(n) only after the whole O(n) range of j has already been scanned
+                accepted = reversedTourLength() < tourLength();
+            }
+            if (accepted) {
+                // the segment is reversed only now that the move is accepted
+                tour.reverse(i, j);
+                obj_value += delta;
+                STATS(stats.two_opt_accepted++; stats.two_opt_gain -= delta;)
                 return true;   // first improvement is accepted as new versione for the graph, another 2-opt iteration will be started
             }
         }
     }
     // if a not improving 2-opt move is found, we return the previous iteration result
-    return improved;
+    return false;
+}
+
+// first improving 2-opt move with a new edge at node v, tried on both tour edges of v
+// the four endpoints of the exchanged edges are returned in touched
+bool TSPHeuristic::improveNode(int v, int touched[4]) {
+    int p = tour.index(v);
+    // index of the edges leaving and entering v, edge q being (tour[q-1], tour[q]) and the start node entered at n
+    int out = p + 1;
+    int in = p == 0 ? n : p;
+
+    for (int side = 0; side < 2; ++side) {
+        int e = side == 0 ? out : in;
+        int other = side == 0 ? tour.node(p + 1) : tour.node(in - 1);
+        double removed = inst.dist(v, other);
+
+        auto tryCandidate = [&](int c) {
+            // leaving v pairs with the edge leaving c, entering v with the edge entering c
+            int f = side == 0 ? tour.index(c) + 1 : (tour.index(c) == 0 ? n : tour.index(c));
+            int lo = std::min(e, f), hi = std::max(e, f);
+            int nodes[4] = {tour.node(lo - 1), tour.node(lo), tour.node(hi - 1), tour.node(hi)};
+            if (!tryTwoOpt(e, f)) return false;
+            std::copy(nodes, nodes + 4, touched);
+            return true;
+        };
+
+        if (inst.hasNeighborLists()) {
+            const int* nl = inst.neighborsOf(v);
+            for (int r = 0; r < inst.k_neighbors; ++r) {
+                int c = nl[r];
+                // candidates are sorted, no shorter new edge can follow
+                if (inst.dist(v, c) >= removed) break;
+                if (tryCandidate(c)) return true;
+            }
+        } else {
+            for (int c = 0; c < n; ++c) {
+                if (c == v || inst.dist(v, c) >= removed) continue;
+                if (tryCandidate(c)) return true;
+            }
+        }
+    }
+    return false;
+}
+
+// queue-driven 2-opt with don't-look bits
+// all nodes start active; a node taken from the queue is searched for an improving move with a new edge at it,
+// if none exists its don't-look bit is set (it leaves the queue) until one of its tour edges changes again
+// after an accepted move only the four endpoints of the exchanged edges are queued, the search ends with an empty queue
+void TSPHeuristic::twoOptDontLookBits() {
+    STATS(PhaseTimer timer(stats.two_opt_time); stats.two_opt_passes++;)
+    std::deque<int> queue;
+    for (int i = 0; i < n; ++i) queue.push_back(tour.node(i));
+    std::vector<char> queued(n, 1);
+
+    while (!queue.empty() && !outOfTime()) {
+        int v = queue.front();
+        queue.pop_front();
+        queued[v] = 0;
+
+        int touched[4];
+        while (improveNode(v, touched)) {
+            reportIncumbent();
+            for (int u : touched) {
+                if (!queued[u]) {
+                    queued[u] = 1;
+                    queue.push_back(u);
+                }
+            }
+        }
+    }
 }
 
 void TSPHeuristic::solve() {
-    auto start = std::chrono::high_resolution_clock::now();
-    greedyInitialization();
+    solve(std::chrono::steady_clock::time_point::max());
+}
 
-    while (twoOptLongEdgeFirst()) {
-        // twoOptLongEdgeFirst() is repeatedly called untill an improvement using a 2-opt is no more possible 
+void TSPHeuristic::solve(std::chrono::steady_clock::time_point until) {
+    auto start = std::chrono::steady_clock::now();
+    solve_start = start;
+    deadline = until;
+    has_deadline = until != std::chrono::steady_clock::time_point::max();
+    time_limit_reached = false;
+    time_checks = 0;
+    stats = SearchStats();
+
+    initialization();
+    // the only full scan of the tour: from now on obj_value is updated with the gain of each accepted move
+    obj_value = tourLength();
+    start_value = obj_value;
+    construction_time = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    STATS(stats.construction_time = construction_time;)
+    reportIncumbent();
+
+    bool improved = true;
+
+    while (improved) {
+        if (two_opt_strategy == TwoOptStrategy::DontLookBits) {
+            twoOptDontLookBits();
+        } else {
+            while (twoOptLongEdgeFirst()) {
+                // twoOptLongEdgeFirst() is repeatedly called untill an improvement using a 2-opt is no more possible 
+                reportIncumbent();
+                // every pass sorts the whole tour first, the deadline is checked between passes as well
+                if (deadlinePassed()) break;
+            }
+        }
+        // if a 3-opt or Or-opt move is performed (TSPAdvHeuristic.cpp), then it will retry with 2-opt local search
+        improved = (three_opt == ThreeOptMoves::Full && threeOptLongEdgeFirst()) ||
+                   (three_opt == ThreeOptMoves::OrOpt && orOptLongEdgeFirst());
+        if (improved) reportIncumbent();
+        if (deadlinePassed()) break;
     }
 
-    obj_value = tourLength(tour);
-    auto end = std::chrono::high_resolution_clock::now();
+    auto end = std::chrono::steady_clock::now();
     solving_time = std::chrono::duration<double>(end - start).count();
+    STATS(stats.reversals = tour.reversalCount(); stats.moved_nodes = tour.movedCount();)
 }
 
+void TSPHeuristic::setTwoOptStrategy(TwoOptStrategy strategy)
+{
+    two_opt_strategy = strategy;
+}
+
+void TSPHeuristic::setThreeOpt(ThreeOptMoves moves)
+{
+    three_opt = moves;
+}
+
+void TSPHeuristic::setConstruction(Construction method)
+{
+    construction = method;
+}
+
+void TSPHeuristic::setStartTour(std::vector<int> closed_tour)
+{
+    start_tour = std::move(closed_tour);
+}
+
+void TSPHeuristic::setIncumbentCallback(IncumbentCallback callback)
+{
+    incumbent_callback = std::move(callback);
+}
 
 double TSPHeuristic::getObjValue() const 
 {
@@ -172,7 +317,27 @@ double TSPHeuristic::getSolvingTime() const
     return solving_time;
 }
 
+double TSPHeuristic::getStartValue() const
+{
+    return start_value;
+}
+
+double TSPHeuristic::getConstructionTime() const
+{
+    return construction_time;
+}
+
+bool TSPHeuristic::getTimeLimitReached() const
+{
+    return time_limit_reached;
+}
+
+const SearchStats& TSPHeuristic::getStats() const
+{
+    return stats;
+}
+
 std::vector<int> TSPHeuristic::getTour() const 
 {
-    return tour;
+    return tour.closedOrder();
 }
\ No newline at end of file
@@ -2,30 +2,104 @@
 #define TSPHEURISTIC_H
 
 #include "TSPInstance.h"
+#include "TSPConstruction.h"
+#include "Tour.h"
+#include "SearchStats.h"
 #include <vector>
 #include <chrono>
+#include <functional>
 
 class TSPHeuristic {
 public:
+    // how the 2-opt local search picks its moves
+    enum class TwoOptStrategy {
+        LongEdgeFirst,  // restart from the longest tour edges after every accepted move
+        DontLookBits    // queue of active nodes, only the endpoints of changed edges are re-examined
+    };
+    // moves of TSPAdvHeuristic.cpp tried whenever the 2-opt search gets stuck
+    enum class ThreeOptMoves {
+        None,
+        Full,   // all 7 reconnections of 3 removed edges
+        OrOpt   // only moves of segments of 1 to 3 nodes
+    };
+
+    // called with the seconds since the start of solve() and the new objective value whenever the tour improves
+    using IncumbentCallback = std::function<void(double elapsed, double objective)>;
+
     explicit TSPHeuristic(const TSPInstance& instance);
 
+    void setTwoOptStrategy(TwoOptStrategy strategy);
+    // enable the 3-opt phase of TSPAdvHeuristic.cpp after each 2-opt descent
+    void setThreeOpt(ThreeOptMoves moves);
+    // how the starting tour is built (TSPConstruction.h), greedy by default
+    void setConstruction(Construction method);
+    // start from this closed tour (node 0 first and last) instead of building one, e.g. a cached tour adapted by
+    // TourCache; an empty tour goes back to the construction
+    void setStartTour(std::vector<int> closed_tour);
+    void setIncumbentCallback(IncumbentCallback callback);
     void solve();
+    // anytime version: the local search stops at the deadline and keeps the best tour found so far, the starting tour
+    // is always completed
+    void solve(std::chrono::steady_clock::time_point deadline);
 
     double getObjValue() const;
     double getSolvingTime() const;
+    // length of the starting tour and time spent building it, included in the solving time
+    double getStartValue() const;
+    double getConstructionTime() const;
+    // solve() stopped at the deadline instead of a local optimum
+    bool getTimeLimitReached() const;
+    // counters of the last solve(), all 0 unless built with TSP_STATS
+    const SearchStats& getStats() const;
     std::vector<int> getTour() const;
 
+    // the move scores of the local searches on any tour, public so that the benchmarks time the same code
+    static double twoOptDelta(const TSPInstance& inst, const Tour& tour, int i, int j);
+    static double threeOptDelta(const TSPInstance& inst, const Tour& tour, int i, int j, int k, int move);
+
 private:
     const TSPInstance& inst;
     int n;
 
-    std::vector<int> tour;
+    Tour tour;              // tour[i] in the comments stands for tour.node(i), pos[v] for tour.index(v)
     double obj_value;
     double solving_time;
+    TwoOptStrategy two_opt_strategy;
+    ThreeOptMoves three_opt;
+    Construction construction;
+    std::vector<int> start_tour;
+    double start_value;
+    double construction_time;
+    SearchStats stats;
+
+    IncumbentCallback incumbent_callback;
+    std::chrono::steady_clock::time_point solve_start;
+    std::chrono::steady_clock::time_point deadline;
+    bool has_deadline = false;
+    bool time_limit_reached = false;
+    unsigned time_checks = 0;
 
-    double tourLength(const std::vector<int>& t) const;
-    void greedyInitialization();
+    bool deadlinePassed();
+    bool outOfTime();
+    void reportIncumbent() const;
+    double tourLength() const;
+    double reversedTourLength() const;
+    double twoOptDelta(int i, int j) const;
+    bool tryTwoOpt(int p, int q);
+    bool twoOptCandidates(int i);
+    void initialization();
     bool twoOptLongEdgeFirst();
+    bool improveNode(int v, int touched[4]);
+    void twoOptDontLookBits();
+    double threeOptDelta(int i, int j, int k, int move) const;
+    void applyThreeOpt(int i, int j, int k, int move, double delta);
+    int edgeIndex(int x, int y) const;
+    bool trySequentialThreeOpt(const int t[6], double delta);
+    bool threeOptCandidates(int i);
+    bool threeOptLongEdgeFirst();
+    bool tryOrOptMove(int s, int e, int q);
+    bool orOptCandidates(int i);
+    bool orOptLongEdgeFirst();
 };
 
 #endif
@@ -1,45 +1,243 @@
 #include "TSPInstance.h"
+#include "SpatialGrid.h"
+#include "MatrixBuilder.h"
+#include "InstanceFile.h"
 #include <fstream>
 #include <cmath>
+#include <cstring>
 #include <stdexcept>
+#include <algorithm>
 
-struct Node {
-    double x;
-    double y;
-};
+bool TSPInstance::isBinaryFile(const std::string& filename) {
+    const std::string ext = ".tspb";
+    return filename.size() >= ext.size() && filename.compare(filename.size() - ext.size(), ext.size(), ext) == 0;
+}
 
-TSPInstance TSPInstance::readFromFile(const std::string& filename) {
+TSPInstance TSPInstance::readFromFile(const std::string& filename, DistanceMode mode) {
+    if (isBinaryFile(filename) || isTSPLIBFile(filename)) {
+        TSPInstance inst = isBinaryFile(filename) ? readBinary(filename) : readTSPLIB(filename);
+        inst.setDistanceMode(mode);
+        return inst;
+    }
     std::ifstream fin(filename);
     if (!fin.is_open()) {
         throw std::runtime_error("Cannot open file " + filename);
     }
 
     TSPInstance inst;
-    fin >> inst.n;
+    int n = 0;
+    fin >> n;
 
-    if (inst.n <= 1){
+    if (n <= 1){
         throw std::runtime_error("Invalid number of nodes");
     }
     
-    std::vector<Node> nodes(inst.n);
+    std::vector<double> x(n), y(n);
 
-    for (int i = 0; i < inst.n; ++i) {
-        fin >> nodes[i].x >> nodes[i].y;
+    for (int i = 0; i < n; ++i) {
+        fin >> x[i] >> y[i];
         if (!fin) {
             throw std::runtime_error("Error reading coordinates in " + filename);
         }
     }
 
-    inst.cost.assign(inst.n, std::vector<double>(inst.n, 0.0));
+    inst.setCoordinates(std::move(x), std::move(y));
+    inst.setDistanceMode(mode);
+
+    return inst;
+}
 
-    for (int i = 0; i < inst.n; i++) {
-        for (int j = 0; j < inst.n; j++) {
-            if (i == j) continue;
-            double dx = nodes[i].x - nodes[j].x;
-            double dy = nodes[i].y - nodes[j].y;
-            inst.cost[i][j] = std::sqrt(dx * dx + dy * dy);
+// the coordinates and the lists are used in place: the instance only keeps the mapping alive.
+// Nothing of the header is trusted before it is checked against the size of the file, a corrupt file is an error
+TSPInstance TSPInstance::readBinary(const std::string& filename) {
+    auto file = std::make_shared<MappedFile>(filename);
+    uint64_t size = file->size();
+    if (size < sizeof(BinaryHeader)) {
+        throw std::runtime_error("Truncated binary instance " + filename);
+    }
+    const BinaryHeader* header = reinterpret_cast<const BinaryHeader*>(file->data());
+    if (std::memcmp(header->magic, BINARY_MAGIC, sizeof(BINARY_MAGIC)) != 0) {
+        throw std::runtime_error("Not a binary instance: " + filename);
+    }
+    if (header->n <= 1) {
+        throw std::runtime_error("Invalid number of nodes");
+    }
+    if (header->k_neighbors < 0 || header->k_neighbors >= header->n) {
+        throw std::runtime_error("Invalid number of candidates in " + filename);
+    }
+    if (header->quadrant != 0 && header->quadrant != 1) {
+        throw std::runtime_error("Invalid candidate list kind in " + filename);
+    }
+    if (header->metric < (int32_t)Metric::Euclidean || header->metric > (int32_t)Metric::Geo) {
+        throw std::runtime_error("Invalid metric in " + filename);
+    }
+    if (header->file_size != size) {
+        throw std::runtime_error("Truncated binary instance " + filename);
+    }
+    // each block inside the file, on the 64-byte boundary the writer puts it on, written so that nothing overflows
+    uint64_t coords = (uint64_t)header->n * sizeof(double);
+    uint64_t lists = (uint64_t)header->n * header->k_neighbors * sizeof(int);
+    auto inside = [&](uint64_t offset, uint64_t length) {
+        return offset % 64 == 0 && offset >= sizeof(BinaryHeader) && offset <= size && length <= size - offset;
+    };
+    if (!inside(header->xs_offset, coords) || !inside(header->ys_offset, coords) ||
+        (header->k_neighbors > 0 && !inside(header->neighbors_offset, lists))) {
+        throw std::runtime_error("Invalid block offsets in " + filename);
+    }
+    // the local searches index the nodes with the list entries without checking them
+    if (header->k_neighbors > 0) {
+        const int* entries = reinterpret_cast<const int*>(file->data() + header->neighbors_offset);
+        for (uint64_t i = 0; i < (uint64_t)header->n * header->k_neighbors; ++i) {
+            if (entries[i] < 0 || entries[i] >= header->n) {
+                throw std::runtime_error("Invalid candidate list entry in " + filename);
+            }
         }
     }
 
+    TSPInstance inst;
+    inst.n = header->n;
+    inst.xs = reinterpret_cast<const double*>(file->data() + header->xs_offset);
+    inst.ys = reinterpret_cast<const double*>(file->data() + header->ys_offset);
+    inst.metric = (Metric)header->metric;
+    inst.content_hash = header->content_hash;
+    if (header->k_neighbors > 0) {
+        inst.file_neighbors = reinterpret_cast<const int*>(file->data() + header->neighbors_offset);
+        inst.file_k_neighbors = header->k_neighbors;
+        inst.file_quadrant = header->quadrant != 0;
+    }
+    inst.coordinate_storage = file;
     return inst;
+}
+
+void TSPInstance::writeBinary(const std::string& filename) const {
+    if (metric == Metric::Explicit) {
+        throw std::runtime_error("EXPLICIT instances have no binary format");
+    }
+    // blocks aligned to 64 bytes, as the rows of the cost matrix
+    auto align = [](uint64_t offset) { return (offset + 63) / 64 * 64; };
+    BinaryHeader header = {};
+    std::memcpy(header.magic, BINARY_MAGIC, sizeof(BINARY_MAGIC));
+    header.n = n;
+    header.k_neighbors = k_neighbors;
+    header.quadrant = quadrant_neighbors ? 1 : 0;
+    header.metric = (int32_t)metric;
+    header.content_hash = content_hash;
+    header.xs_offset = align(sizeof(BinaryHeader));
+    header.ys_offset = align(header.xs_offset + (uint64_t)n * sizeof(double));
+    header.neighbors_offset = align(header.ys_offset + (uint64_t)n * sizeof(double));
+    header.file_size = header.neighbors_offset + (uint64_t)n * k_neighbors * sizeof(int);
+
+    std::ofstream fout(filename, std::ios::binary);
+    if (!fout.is_open()) {
+        throw std::runtime_error("Cannot open file " + filename);
+    }
+    auto writeAt = [&](uint64_t offset, const void* bytes, size_t count) {
+        // zero padding up to the start of the block
+        static const char zeros[64] = {};
+        fout.write(zeros, offset - (uint64_t)fout.tellp());
+        fout.write(static_cast<const char*>(bytes), count);
+    };
+    writeAt(0, &header, sizeof(header));
+    writeAt(header.xs_offset, xs, (size_t)n * sizeof(double));
+    writeAt(header.ys_offset, ys, (size_t)n * sizeof(double));
+    writeAt(header.neighbors_offset, neighbors, (size_t)n * k_neighbors * sizeof(int));
+    if (!fout) {
+        throw std::runtime_error("Error writing " + filename);
+    }
+}
+
+void TSPInstance::setCoordinates(std::vector<double> x, std::vector<double> y) {
+    struct Coordinates {
+        std::vector<double> x, y;
+    };
+    auto coords = std::make_shared<Coordinates>(Coordinates{std::move(x), std::move(y)});
+    n = (int)coords->x.size();
+    xs = coords->x.data();
+    ys = coords->y.data();
+    content_hash = contentHash(n, xs, ys);
+    coordinate_storage = coords;
+    file_neighbors = nullptr;
+    file_k_neighbors = 0;
+}
+
+void TSPInstance::setDistanceMode(DistanceMode mode) {
+    // the weights of an EXPLICIT instance only exist in the matrix
+    if (metric == Metric::Explicit && (mode == DistanceMode::Lazy || mode == DistanceMode::Auto)) {
+        bool packed = hasCostMatrix() && cost.storage() == CostMatrix::Storage::Packed;
+        mode = packed ? DistanceMode::PackedMatrix : DistanceMode::Matrix;
+    }
+    if (mode == DistanceMode::Auto) {
+        mode = n <= MAX_MATRIX_NODES ? DistanceMode::Matrix : DistanceMode::Lazy;
+    }
+    if (mode == DistanceMode::Lazy) {
+        // release the memory of the matrix
+        cost = CostMatrix();
+        return;
+    }
+    CostMatrix::Storage storage = mode == DistanceMode::PackedMatrix ? CostMatrix::Storage::Packed : CostMatrix::Storage::Full;
+    if (hasCostMatrix() && cost.storage() == storage) return;
+
+    CostMatrix matrix(n, storage);
+    if (metric == Metric::Euclidean) {
+        buildCostMatrix(matrix, xs, ys);
+    } else {
+        // rounded distances, or the EXPLICIT weights moved to the other storage
+        for (int i = 0; i < n; ++i)
+            for (int j = i + 1; j < n; ++j) matrix.set(i, j, metric == Metric::Explicit ? cost(i, j) : roundedDist(i, j));
+    }
+    cost = std::move(matrix);
+}
+
+// candidate lists are built with a spatial grid, so each node only looks at the few cells around it
+// instead of all the other n-1 nodes
+void TSPInstance::buildNeighborLists(int k, bool quadrant) {
+    k = std::min(k, n - 1);
+    if (k <= 0) {
+        k_neighbors = 0;
+        neighbors = nullptr;
+        neighbor_storage.reset();
+        return;
+    }
+    quadrant_neighbors = quadrant;
+    k_neighbors = k;
+    if (file_neighbors && file_k_neighbors == k && file_quadrant == quadrant) {
+        neighbors = file_neighbors;
+        neighbor_storage.reset();
+        return;
+    }
+    auto lists = std::make_shared<std::vector<int>>((size_t)n * k, -1);
+
+    if (metric == Metric::Explicit) {
+        // the k lightest entries of each row of the matrix, the display coordinates are no distances
+        quadrant_neighbors = false;
+        std::vector<int> others(n - 1);
+        for (int i = 0; i < n; ++i) {
+            for (int j = 0, c = 0; j < n; ++j)
+                if (j != i) others[c++] = j;
+            std::partial_sort(others.begin(), others.begin() + k, others.end(),
+                              [&](int a, int b) { return dist(i, a) < dist(i, b); });
+            std::copy(others.begin(), others.begin() + k, lists->begin() + (size_t)i * k);
+        }
+        neighbors = lists->data();
+        neighbor_storage = lists;
+        return;
+    }
+
+    SpatialGrid grid(n, xs, ys);
+    for (int i = 0; i < n; ++i) {
+        std::vector<int> list = quadrant ? grid.quadrantNearest(i, k) : grid.kNearest(i, k);
+        // the rounded metrics never decrease with the Euclidean distance, but on the sphere the plane order of the
+        // coordinates is only an approximation: the searches expect the lists sorted by dist()
+        if (metric == Metric::Geo) {
+            std::stable_sort(list.begin(), list.end(), [&](int a, int b) { return dist(i, a) < dist(i, b); });
+        }
+        std::copy(list.begin(), list.end(), lists->begin() + (size_t)i * k);
+    }
+    neighbors = lists->data();
+    neighbor_storage = lists;
+}
+
+bool TSPInstance::isNeighbor(int i, int j) const {
+    const int* list = neighborsOf(i);
+    return std::find(list, list + k_neighbors, j) != list + k_neighbors;
 }
\ No newline at end of file
@@ -1,15 +1,99 @@
 #ifndef TSPINSTANCE_H
 #define TSPINSTANCE_H
 
+#include "CostMatrix.h"
 #include <vector>
 #include <string>
+#include <cmath>
+#include <cstdint>
+#include <memory>
 
 class TSPInstance {
 public:
+    // how the solvers obtain the distance between two nodes
+    enum class DistanceMode {
+        Matrix,         // precomputed n x n matrix, 8 n^2 bytes
+        PackedMatrix,   // precomputed upper triangle only, 4 n^2 bytes
+        Lazy,           // Euclidean distance computed on demand from the coordinates, O(n) memory
+        Auto            // matrix up to MAX_MATRIX_NODES nodes, lazy above
+    };
+    static const int MAX_MATRIX_NODES = 5000;
+
+    // how the distance between two nodes is obtained from the file, the EDGE_WEIGHT_TYPE of a TSPLIB file
+    enum class Metric {
+        Euclidean,  // exact Euclidean distance, the instances of the generator
+        Euc2D,      // Euclidean distance rounded to the nearest integer
+        Ceil2D,     // Euclidean distance rounded up
+        Att,        // pseudo-Euclidean distance of att48 and att532
+        Geo,        // great circle distance in km, coordinates given as DDD.MM latitude and longitude
+        Explicit    // weights listed in the file, always kept in the cost matrix
+    };
+
     int n;
-    std::vector<std::vector<double>> cost;
+    Metric metric = Metric::Euclidean;
+    // dense distance matrix, empty in lazy mode: use dist() rather than reading it directly
+    CostMatrix cost;
+    // coordinates of the nodes as read from the instance file (structure of arrays), n entries each
+    // read-only: they may point into the mapping of a binary file, set them with setCoordinates()
+    // null for an EXPLICIT TSPLIB instance without display coordinates
+    const double* xs = nullptr;
+    const double* ys = nullptr;
+    // FNV-1a hash of n and the coordinates, the same for the text and the binary file of an instance
+    uint64_t content_hash = 0;
+
+    // candidate lists: the neighbors of node i are neighborsOf(i)[0 .. k_neighbors), closest first
+    int k_neighbors = 0;
+    bool quadrant_neighbors = false;
+
+    // text file (.dat, the node count and then one "x y" line per node), binary file (.tspb, InstanceFile.h)
+    // or TSPLIB file (.tsp, TSPLib.cpp)
+    static TSPInstance readFromFile(const std::string& filename, DistanceMode mode = DistanceMode::Auto);
+    static bool isBinaryFile(const std::string& filename);
+    static bool isTSPLIBFile(const std::string& filename);
+    // DIMENSION of a TSPLIB file, read from its header only; 0 if it is missing
+    static int peekTSPLIBDimension(const std::string& filename);
+    // write the instance as a binary file, with its candidate lists if it has some
+    void writeBinary(const std::string& filename) const;
+
+    void setCoordinates(std::vector<double> x, std::vector<double> y);
+    bool hasCoordinates() const { return xs != nullptr; }
+
+    // switch between the distance modes after loading; an EXPLICIT instance always keeps a matrix
+    void setDistanceMode(DistanceMode mode);
+    bool hasCostMatrix() const { return !cost.empty(); }
+
+    // distance between nodes i and j, the single accessor used by all the heuristics
+    double dist(int i, int j) const {
+        if (!cost.empty()) return cost(i, j);
+        if (metric != Metric::Euclidean) return roundedDist(i, j);
+        double dx = xs[i] - xs[j];
+        double dy = ys[i] - ys[j];
+        return std::sqrt(dx * dx + dy * dy);
+    }
+
+    // precompute the k nearest neighbors of every node (optionally balanced over the 4 quadrants around it)
+    // the lists stored in a binary file are used as they are when they were built with the same k and quadrant
+    void buildNeighborLists(int k, bool quadrant = false);
+    bool hasNeighborLists() const { return k_neighbors > 0; }
+    const int* neighborsOf(int i) const { return neighbors + (size_t)i * k_neighbors; }
+    // true if j is on the candidate list of i
+    bool isNeighbor(int i, int j) const;
+
+private:
+    const int* neighbors = nullptr;
+    // memory behind xs, ys and neighbors: vectors or a file mapping, shared by the copies of the instance
+    std::shared_ptr<const void> coordinate_storage;
+    std::shared_ptr<const void> neighbor_storage;
+    // candidate lists found in the binary file, kept aside until buildNeighborLists() asks for the same ones
+    const int* file_neighbors = nullptr;
+    int file_k_neighbors = 0;
+    bool file_quadrant = false;
 
-    static TSPInstance readFromFile(const std::string& filename);
+    static TSPInstance readBinary(const std::string& filename);
+    static TSPInstance readTSPLIB(const std::string& filename);
+    // distance of the TSPLIB metrics computed from the coordinates; pure, so that the call in dist() does not make
+    // the callers reload the instance after it
+    __attribute__((pure)) double roundedDist(int i, int j) const;
 };
 
 #endif
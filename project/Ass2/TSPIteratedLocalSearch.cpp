@@ -0,0 +1,213 @@
+#include "TSPIteratedLocalSearch.h"
+#include "TSPLinKernighan.h"
+#include <algorithm>
+#include <random>
+#include <thread>
+#include <stdexcept>
+#include <utility>
+
+// kicks must improve the tour by more than this amount to be kept
+static const double ILS_EPS = 1e-9;
+// the two segments swapped by a double bridge have at most this many nodes, so that a kick and its
+// re-optimization stay local whatever the size of the instance
+static const int MAX_SEGMENT = 50;
+// a worker publishes its tour at most this often (seconds), and once more when it stops
+static const double PUBLISH_INTERVAL = 0.1;
+// kicks between two reads of the shared incumbent value, every read touches the counter all the workers share
+static const int REFRESH_PERIOD = 64;
+
+TSPIteratedLocalSearch::TSPIteratedLocalSearch(const TSPInstance& instance):inst(instance),n(instance.n),threads(1),time_limit(1.0),max_iterations(0),seed(1),construction(Construction::Greedy),layout(Tour::Layout::Auto),obj_value(0.0),solving_time(0.0),start_value(0.0),construction_time(0.0),local_optimum_value(0.0),iterations(0),reported_value(0.0) {}
+
+void TSPIteratedLocalSearch::worker(int w, const std::vector<int>& start_tour,
+                                    std::chrono::steady_clock::time_point deadline, IncumbentSlot& slot,
+                                    long long& kicks) {
+    TSPLinKernighan ls(inst);
+    ls.setTourLayout(layout);
+    ls.loadTour(start_tour);
+    double best = ls.getObjValue();
+    // incumbent value as last read from the slot
+    double incumbent = slot.value();
+    bool unpublished = false;
+    auto last_publish = std::chrono::steady_clock::now();
+
+    std::mt19937_64 rng(seed + w);
+    int max_segment = std::min(MAX_SEGMENT, (n - 2) / 2);
+    std::uniform_int_distribution<int> segment(1, max_segment);
+
+    for (kicks = 0; max_iterations == 0 || kicks < max_iterations; ++kicks) {
+        // the clock is read every few kicks only, a kick on a small instance takes less than a microsecond
+        if ((kicks & 15) == 0 && std::chrono::steady_clock::now() >= deadline) break;
+
+        int len_b = segment(rng);
+        int len_c = segment(rng);
+        int first = std::uniform_int_distribution<int>(0, n - 2 - len_b - len_c)(rng);
+
+        ls.beginTrial();
+        ls.optimize(ls.doubleBridge(first, len_b, len_c));
+        if (ls.getObjValue() < best - ILS_EPS) {
+            ls.commitTrial();
+            best = ls.getObjValue();
+            unpublished = true;
+        } else {
+            ls.rollbackTrial();
+        }
+
+        if (kicks % REFRESH_PERIOD == 0) incumbent = slot.value();
+        if (unpublished && best < incumbent) {
+            auto now = std::chrono::steady_clock::now();
+            if (std::chrono::duration<double>(now - last_publish).count() >= PUBLISH_INTERVAL) {
+                publish(slot, best, w, ls.getTour());
+                incumbent = slot.value();
+                unpublished = false;
+                last_publish = now;
+            }
+        }
+    }
+    publish(slot, best, w, ls.getTour());
+}
+
+// offer the tour of worker w to the slot and report it if the slot takes it; two workers may be taken one after the
+// other and report in the opposite order, and workers often reach the same tour, so only a value clearly below the last
+// one reported is passed on
+void TSPIteratedLocalSearch::publish(IncumbentSlot& slot, double value, int w, const std::vector<int>& tour) {
+    if (!slot.offer(value, w, tour) || !incumbent_callback) return;
+    std::lock_guard<std::mutex> lock(report_mutex);
+    if (value >= reported_value - ILS_EPS) return;
+    reported_value = value;
+    incumbent_callback(std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count(), value);
+}
+
+void TSPIteratedLocalSearch::solve() {
+    if (!inst.hasNeighborLists()) {
+        throw std::runtime_error("Iterated local search needs the candidate lists of the instance");
+    }
+    auto start = std::chrono::steady_clock::now();
+    start_time = start;
+    auto deadline = start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                                std::chrono::duration<double>(time_limit));
+
+    // first local optimum, shared by all the workers; on the largest instances the time limit may already stop it
+    TSPLinKernighan lk(inst);
+    lk.setConstruction(construction);
+    lk.setStartTour(initial_tour);
+    lk.setTourLayout(layout);
+    lk.setIncumbentCallback(incumbent_callback);
+    lk.solve(deadline);
+    time_limit_reached = lk.getTimeLimitReached();
+    start_value = lk.getStartValue();
+    construction_time = lk.getConstructionTime();
+    local_optimum_value = lk.getObjValue();
+    std::vector<int> start_tour = lk.getTour();
+
+    tour = start_tour;
+    obj_value = local_optimum_value;
+    reported_value = local_optimum_value;
+    iterations = 0;
+
+    // a double bridge needs two segments and a node on each side: smaller instances end at the first local optimum,
+    // getIterations() is 0
+    if (n >= 8) {
+        int workers = threads > 0 ? threads : std::max(1u, std::thread::hardware_concurrency());
+        IncumbentSlot slot;
+        slot.offer(local_optimum_value, workers, start_tour);
+
+        std::vector<long long> kicks(workers, 0);
+        std::vector<std::thread> pool;
+        for (int w = 0; w < workers; ++w) {
+            pool.emplace_back(&TSPIteratedLocalSearch::worker, this, w, std::cref(start_tour), deadline,
+                              std::ref(slot), std::ref(kicks[w]));
+        }
+        for (auto& t : pool) t.join();
+
+        for (long long k : kicks) {
+            iterations += k;
+            if (max_iterations == 0 || k < max_iterations) time_limit_reached = true;
+        }
+        tour = slot.tour();
+        // the workers track their length with the gain of each move, the final one is summed again from scratch
+        obj_value = 0.0;
+        for (int i = 0; i < n; ++i) obj_value += inst.dist(tour[i], tour[i + 1]);
+    }
+
+    solving_time = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+void TSPIteratedLocalSearch::setThreads(int t)
+{
+    threads = t;
+}
+
+void TSPIteratedLocalSearch::setTimeLimit(double seconds)
+{
+    time_limit = seconds;
+}
+
+void TSPIteratedLocalSearch::setMaxIterations(long long iters)
+{
+    max_iterations = iters;
+}
+
+void TSPIteratedLocalSearch::setIncumbentCallback(IncumbentCallback callback)
+{
+    incumbent_callback = std::move(callback);
+}
+
+void TSPIteratedLocalSearch::setSeed(unsigned long long s)
+{
+    seed = s;
+}
+
+void TSPIteratedLocalSearch::setConstruction(Construction method)
+{
+    construction = method;
+}
+
+void TSPIteratedLocalSearch::setStartTour(std::vector<int> closed_tour)
+{
+    initial_tour = std::move(closed_tour);
+}
+
+void TSPIteratedLocalSearch::setTourLayout(Tour::Layout tour_layout)
+{
+    layout = tour_layout;
+}
+
+double TSPIteratedLocalSearch::getObjValue() const
+{
+    return obj_value;
+}
+
+double TSPIteratedLocalSearch::getSolvingTime() const
+{
+    return solving_time;
+}
+
+double TSPIteratedLocalSearch::getStartValue() const
+{
+    return start_value;
+}
+
+double TSPIteratedLocalSearch::getConstructionTime() const
+{
+    return construction_time;
+}
+
+double TSPIteratedLocalSearch::getLocalOptimumValue() const
+{
+    return local_optimum_value;
+}
+
+bool TSPIteratedLocalSearch::getTimeLimitReached() const
+{
+    return time_limit_reached;
+}
+
+long long TSPIteratedLocalSearch::getIterations() const
+{
+    return iterations;
+}
+
+std::vector<int> TSPIteratedLocalSearch::getTour() const
+{
+    return tour;
+}
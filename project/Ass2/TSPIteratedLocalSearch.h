@@ -0,0 +1,88 @@
+#ifndef TSPITERATEDLOCALSEARCH_H
+#define TSPITERATEDLOCALSEARCH_H
+
+#include "TSPInstance.h"
+#include "TSPConstruction.h"
+#include "IncumbentSlot.h"
+#include "Tour.h"
+#include <vector>
+#include <chrono>
+#include <functional>
+#include <mutex>
+
+// iterated local search on top of TSPLinKernighan
+// after a first Lin-Kernighan descent, every worker thread repeatedly kicks its own copy of the tour with a random
+// double bridge, re-optimizes only around the kick and keeps the result if it is shorter, undoing it otherwise.
+// Improvements are published to a shared IncumbentSlot; the search stops at the time limit or after the given
+// number of kicks per worker. With an iteration limit the result only depends on the seed and the number of workers
+// the instance must have candidate lists, as for TSPLinKernighan
+class TSPIteratedLocalSearch {
+public:
+    // called with the seconds since the start of solve() and the objective value: by the first descent for each of
+    // its improvements, then by the workers each time the IncumbentSlot takes a shorter tour from one of them. The
+    // calls never overlap and their values decrease
+    using IncumbentCallback = std::function<void(double elapsed, double objective)>;
+
+    explicit TSPIteratedLocalSearch(const TSPInstance& instance);
+
+    // number of worker threads, 0 = one per hardware thread
+    void setThreads(int threads);
+    // wall-clock budget of the whole solve() in seconds
+    void setTimeLimit(double seconds);
+    // kicks per worker, 0 = until the time limit
+    void setMaxIterations(long long iterations);
+    // worker w draws its kicks from a generator seeded with seed + w
+    void setSeed(unsigned long long seed);
+    void setConstruction(Construction method);
+    // start of the first descent, as TSPHeuristic::setStartTour
+    void setStartTour(std::vector<int> closed_tour);
+    // tour layout of every worker (Tour.h)
+    void setTourLayout(Tour::Layout tour_layout);
+    void setIncumbentCallback(IncumbentCallback callback);
+    void solve();
+
+    double getObjValue() const;
+    double getSolvingTime() const;
+    double getStartValue() const;
+    double getConstructionTime() const;
+    // value after the first Lin-Kernighan descent, before any kick
+    double getLocalOptimumValue() const;
+    // kicks tried by all the workers
+    long long getIterations() const;
+    // the search ended at the time limit rather than after the given number of kicks
+    bool getTimeLimitReached() const;
+    std::vector<int> getTour() const;
+
+private:
+    const TSPInstance& inst;
+    int n;
+
+    int threads;
+    double time_limit;
+    long long max_iterations;
+    unsigned long long seed;
+    Construction construction;
+    std::vector<int> initial_tour;
+    Tour::Layout layout;
+    IncumbentCallback incumbent_callback;
+
+    std::vector<int> tour;
+    double obj_value;
+    double solving_time;
+    double start_value;
+    double construction_time;
+    double local_optimum_value;
+    long long iterations;
+    bool time_limit_reached = false;
+
+    // incumbent reported by the workers
+    std::chrono::steady_clock::time_point start_time;
+    std::mutex report_mutex;
+    double reported_value;
+
+    void worker(int w, const std::vector<int>& start_tour, std::chrono::steady_clock::time_point deadline,
+                IncumbentSlot& slot, long long& kicks);
+    void publish(IncumbentSlot& slot, double value, int w, const std::vector<int>& tour);
+};
+
+#endif
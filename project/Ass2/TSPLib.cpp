@@ -0,0 +1,246 @@
+#include "TSPInstance.h"
+#include "InstanceFile.h"
+#include <charconv>
+#include <fstream>
+#include <stdexcept>
+#include <cmath>
+#include <cstdlib>
+
+// TSPLIB files (.tsp) of the symmetric TSP: EUC_2D, CEIL_2D, ATT and GEO coordinates, or EXPLICIT weights in
+// FULL_MATRIX, UPPER_ROW, UPPER_DIAG_ROW, LOWER_ROW or LOWER_DIAG_ROW format.
+// The whole file is read into one buffer and scanned once, numbers are converted in place with std::from_chars
+
+// constants of the GEO distance exactly as the TSPLIB documentation gives them
+static const double GEO_PI = 3.141592;
+static const double GEO_RADIUS = 6378.388;
+
+namespace {
+
+class Scanner {
+public:
+    Scanner(const char* begin, const char* end, const std::string& filename):p(begin),end(end),filename(filename) {}
+
+    bool atEnd() {
+        skipBlanks();
+        return p == end;
+    }
+    // next keyword, up to a blank or a ':'
+    std::string word() {
+        skipBlanks();
+        const char* s = p;
+        while (p < end && !isBlank(*p) && *p != ':') ++p;
+        return std::string(s, p);
+    }
+    // rest of a header line after its ':', trimmed
+    std::string value() {
+        while (p < end && (*p == ' ' || *p == '\t')) ++p;
+        if (p < end && *p == ':') ++p;
+        while (p < end && (*p == ' ' || *p == '\t')) ++p;
+        const char* s = p;
+        while (p < end && *p != '\n' && *p != '\r') ++p;
+        const char* e = p;
+        while (e > s && (e[-1] == ' ' || e[-1] == '\t')) --e;
+        return std::string(s, e);
+    }
+    template <class T>
+    T number() {
+        skipBlanks();
+        // from_chars does not take a leading '+'
+        if (p < end && *p == '+') ++p;
+        T v;
+        auto res = std::from_chars(p, end, v);
+        if (res.ec != std::errc()) {
+            throw std::runtime_error("Error reading a number in " + filename);
+        }
+        p = res.ptr;
+        return v;
+    }
+
+private:
+    const char* p;
+    const char* end;
+    const std::string& filename;
+
+    static bool isBlank(char c) { return c == ' ' || c == '\t' || c == '\n' || c == '\r'; }
+    void skipBlanks() {
+        while (p < end && isBlank(*p)) ++p;
+    }
+};
+
+}
+
+// the weights go straight into the matrix in the order the format lists them, only the upper triangle is needed
+static void readWeights(Scanner& in, CostMatrix& cost, int n, const std::string& format) {
+    int first, last;    // columns read from row i: [first(i), last(i)) for the given format
+    auto row = [&](int i) {
+        if (format == "FULL_MATRIX") { first = 0; last = n; }
+        else if (format == "UPPER_ROW") { first = i + 1; last = n; }
+        else if (format == "UPPER_DIAG_ROW") { first = i; last = n; }
+        else if (format == "LOWER_ROW") { first = 0; last = i; }
+        else if (format == "LOWER_DIAG_ROW") { first = 0; last = i + 1; }
+        else throw std::runtime_error("Unsupported EDGE_WEIGHT_FORMAT " + format);
+    };
+    for (int i = 0; i < n; ++i) {
+        row(i);
+        for (int j = first; j < last; ++j) {
+            double w = in.number<double>();
+            // a full matrix lists every pair twice
+            if (format != "FULL_MATRIX" || j >= i) cost.set(i, j, w);
+        }
+    }
+}
+
+bool TSPInstance::isTSPLIBFile(const std::string& filename) {
+    const std::string ext = ".tsp";
+    return filename.size() >= ext.size() && filename.compare(filename.size() - ext.size(), ext.size(), ext) == 0;
+}
+
+int TSPInstance::peekTSPLIBDimension(const std::string& filename) {
+    std::ifstream fin(filename);
+    std::string line;
+    while (std::getline(fin, line)) {
+        if (line.find("_SECTION") != std::string::npos) break;
+        if (line.compare(0, 9, "DIMENSION") != 0) continue;
+        size_t colon = line.find(':');
+        return colon == std::string::npos ? 0 : std::atoi(line.c_str() + colon + 1);
+    }
+    return 0;
+}
+
+TSPInstance TSPInstance::readTSPLIB(const std::string& filename) {
+    std::ifstream fin(filename, std::ios::binary);
+    if (!fin.is_open()) {
+        throw std::runtime_error("Cannot open file " + filename);
+    }
+    std::string buffer;
+    fin.seekg(0, std::ios::end);
+    buffer.resize((size_t)fin.tellg());
+    fin.seekg(0);
+    fin.read(&buffer[0], buffer.size());
+    Scanner in(buffer.data(), buffer.data() + buffer.size(), filename);
+
+    TSPInstance inst;
+    int n = 0;
+    std::string weight_type, weight_format;
+    std::vector<double> x, y;
+    bool has_coordinates = false, has_weights = false;
+
+    while (!in.atEnd()) {
+        std::string key = in.word();
+        if (key == "EOF") break;
+
+        if (key == "NODE_COORD_SECTION" || key == "DISPLAY_DATA_SECTION") {
+            if (n <= 1) {
+                throw std::runtime_error("Invalid number of nodes");
+            }
+            // display coordinates only stand in for missing node coordinates
+            bool keep = !has_coordinates;
+            if (keep) {
+                x.assign(n, 0.0);
+                y.assign(n, 0.0);
+            }
+            for (int k = 0; k < n; ++k) {
+                int id = in.number<int>();
+                double xi = in.number<double>(), yi = in.number<double>();
+                if (id < 1 || id > n) {
+                    throw std::runtime_error("Invalid node id in " + filename);
+                }
+                if (keep) {
+                    x[id - 1] = xi;
+                    y[id - 1] = yi;
+                }
+            }
+            has_coordinates = true;
+        } else if (key == "EDGE_WEIGHT_SECTION") {
+            if (weight_type != "EXPLICIT" || n <= 1) {
+                throw std::runtime_error("EDGE_WEIGHT_SECTION without EXPLICIT weights in " + filename);
+            }
+            inst.cost = CostMatrix(n);
+            readWeights(in, inst.cost, n, weight_format);
+            has_weights = true;
+        } else if (key.size() > 8 && key.compare(key.size() - 8, 8, "_SECTION") == 0) {
+            throw std::runtime_error("Unsupported " + key + " in " + filename);
+        } else {
+            std::string value = in.value();
+            if (key == "TYPE" && value.compare(0, 3, "TSP") != 0) {
+                throw std::runtime_error("Only symmetric TSP files are supported, " + filename + " is " + value);
+            } else if (key == "DIMENSION") {
+                n = std::atoi(value.c_str());
+            } else if (key == "EDGE_WEIGHT_TYPE") {
+                weight_type = value;
+            } else if (key == "EDGE_WEIGHT_FORMAT") {
+                weight_format = value;
+            }
+            // NAME, COMMENT, NODE_COORD_TYPE, DISPLAY_DATA_TYPE: nothing to keep
+        }
+    }
+
+    if (n <= 1) {
+        throw std::runtime_error("Invalid number of nodes");
+    }
+    if (weight_type == "EUC_2D") inst.metric = Metric::Euc2D;
+    else if (weight_type == "CEIL_2D") inst.metric = Metric::Ceil2D;
+    else if (weight_type == "ATT") inst.metric = Metric::Att;
+    else if (weight_type == "GEO") inst.metric = Metric::Geo;
+    else if (weight_type == "EXPLICIT") inst.metric = Metric::Explicit;
+    else throw std::runtime_error("Unsupported EDGE_WEIGHT_TYPE " + weight_type + " in " + filename);
+
+    if (inst.metric == Metric::Explicit ? !has_weights : !has_coordinates) {
+        throw std::runtime_error("Missing " + std::string(inst.metric == Metric::Explicit ? "EDGE_WEIGHT" : "NODE_COORD") +
+                                 "_SECTION in " + filename);
+    }
+    if (has_coordinates) {
+        inst.setCoordinates(std::move(x), std::move(y));
+    } else {
+        inst.n = n;
+    }
+    // the same coordinates under another metric are another instance
+    int metric_id = (int)inst.metric;
+    if (inst.metric == Metric::Explicit) {
+        uint64_t hash = fnv1a(&n, sizeof(n));
+        for (int i = 0; i < n; ++i) {
+            for (int j = i + 1; j < n; ++j) {
+                double w = inst.cost(i, j);
+                hash = fnv1a(&w, sizeof(w), hash);
+            }
+        }
+        inst.content_hash = fnv1a(&metric_id, sizeof(metric_id), hash);
+    } else {
+        inst.content_hash = fnv1a(&metric_id, sizeof(metric_id), inst.content_hash);
+    }
+    return inst;
+}
+
+// nint(x) of the TSPLIB documentation is (int)(x + 0.5)
+double TSPInstance::roundedDist(int i, int j) const {
+    double dx = xs[i] - xs[j];
+    double dy = ys[i] - ys[j];
+    switch (metric) {
+        case Metric::Euc2D:
+            return std::floor(std::sqrt(dx * dx + dy * dy) + 0.5);
+        case Metric::Ceil2D:
+            return std::ceil(std::sqrt(dx * dx + dy * dy));
+        case Metric::Att: {
+            double r = std::sqrt((dx * dx + dy * dy) / 10.0);
+            double t = std::floor(r + 0.5);
+            return t < r ? t + 1.0 : t;
+        }
+        case Metric::Geo: {
+            if (i == j) return 0.0;
+            // DDD.MM: whole degrees, then minutes as the fractional part
+            auto radians = [](double v) {
+                double deg = std::trunc(v);
+                return GEO_PI * (deg + 5.0 * (v - deg) / 3.0) / 180.0;
+            };
+            double lat_i = radians(xs[i]), lon_i = radians(ys[i]);
+            double lat_j = radians(xs[j]), lon_j = radians(ys[j]);
+            double q1 = std::cos(lon_i - lon_j);
+            double q2 = std::cos(lat_i - lat_j);
+            double q3 = std::cos(lat_i + lat_j);
+            return std::floor(GEO_RADIUS * std::acos(0.5 * ((1.0 + q1) * q2 - (1.0 - q1) * q3)) + 1.0);
+        }
+        default:
+            break;
+    }
+    return std::sqrt(dx * dx + dy * dy);
+}
@@ -0,0 +1,298 @@
+#include "TSPLinKernighan.h"
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
+
+// moves must improve the tour by more than this amount, rounding errors must not make the search cycle
+static const double LK_EPS = 1e-9;
+
+TSPLinKernighan::TSPLinKernighan(const TSPInstance& instance):inst(instance),n(instance.n),obj_value(0.0),solving_time(0.0),construction(Construction::Greedy),start_value(0.0),construction_time(0.0),layout(Tour::Layout::Auto),max_depth(50),breadth{5, 3},t1(-1) {}
+
+int TSPLinKernighan::succ(int v) const {
+    return tour.next(v);
+}
+
+int TSPLinKernighan::pred(int v) const {
+    return tour.prev(v);
+}
+
+// reverse the path from `from` to `to` following succ, Tour moves the shorter side
+void TSPLinKernighan::flip(int from, int to) {
+    tour.flip(from, to);
+    flips.push_back({from, to});
+}
+
+// after the flip the path runs from `to` to `from`: flipping it back restores the tour
+void TSPLinKernighan::undoFlip() {
+    Flip f = flips.back();
+    flips.pop_back();
+    tour.flip(f.to, f.from);
+}
+
+// the clock is read once every 256 nodes taken from the queue, and never without a deadline
+bool TSPLinKernighan::outOfTime() {
+    if (time_limit_reached) return true;
+    if (deadline == std::chrono::steady_clock::time_point::max() || (++time_checks & 255) != 0) return false;
+    time_limit_reached = std::chrono::steady_clock::now() >= deadline;
+    return time_limit_reached;
+}
+
+bool TSPLinKernighan::wasAdded(int a, int b) const {
+    for (const auto& e : added) {
+        if ((e.first == a && e.second == b) || (e.first == b && e.second == a)) return true;
+    }
+    return false;
+}
+
+// one level of the chain: the edge (t1, t2) is removed with cumulative gain `gain` (removed minus added so far)
+// t3 is picked among the candidates of t2 and t4 is the neighbor of t3 that keeps a Hamiltonian cycle when
+// (t3, t4) is removed and (t4, t1) closes the tour; the flip is applied right away so that the next level
+// starts again from a proper tour whose edge (t1, t4) is the next one to remove
+bool TSPLinKernighan::step(int level, int t2, double gain) {
+    // t2 follows t1 in the current orientation or precedes it
+    bool forward = succ(t1) == t2;
+
+    struct Candidate {
+        int t3, t4;
+        double score;   // gain after removing (t3, t4), LK lookahead rule
+    };
+    std::vector<Candidate> cands;
+    const int* nl = inst.neighborsOf(t2);
+    for (int r = 0; r < inst.k_neighbors; ++r) {
+        int t3 = nl[r];
+        double g1 = gain - inst.dist(t2, t3);
+        // positive gain criterion, candidates are sorted so no later one can satisfy it
+        if (g1 <= LK_EPS) break;
+        if (t3 == t1 || t3 == succ(t2) || t3 == pred(t2)) continue;
+        int t4 = forward ? pred(t3) : succ(t3);
+        if (t4 == t2 || wasAdded(t3, t4)) continue;
+        cands.push_back({t3, t4, g1 + inst.dist(t3, t4)});
+    }
+    std::sort(cands.begin(), cands.end(), [](const Candidate& a, const Candidate& b) { return a.score > b.score; });
+
+    int width = level <= 2 ? breadth[level - 1] : 1;
+    for (int c = 0; c < (int)cands.size() && c < width; ++c) {
+        int t3 = cands[c].t3, t4 = cands[c].t4;
+
+        // remove (t1, t2), (t4, t3) and add (t2, t3), (t4, t1)
+        if (forward) {
+            flip(t2, t4);
+        } else {
+            flip(t4, t2);
+        }
+        added.emplace_back(t2, t3);
+
+        double new_gain = cands[c].score;
+        double closed_gain = new_gain - inst.dist(t4, t1);
+        if (closed_gain > LK_EPS) {
+            // first improving closure is kept
+            obj_value -= closed_gain;
+            touched.insert(touched.end(), {t2, t3, t4});
+            return true;
+        }
+        if (level < max_depth && step(level + 1, t4, new_gain)) {
+            touched.insert(touched.end(), {t2, t3, t4});
+            return true;
+        }
+
+        added.pop_back();
+        undoFlip();
+    }
+    return false;
+}
+
+// try to start an improving move from node v, with either of its tour edges as the first removed one
+bool TSPLinKernighan::improveFrom(int v) {
+    t1 = v;
+    for (int t2 : {succ(v), pred(v)}) {
+        flips.clear();
+        added.clear();
+        touched.clear();
+        if (step(1, t2, inst.dist(t1, t2))) {
+            touched.push_back(t1);
+            return true;
+        }
+    }
+    return false;
+}
+
+void TSPLinKernighan::solve() {
+    solve(std::chrono::steady_clock::time_point::max());
+}
+
+void TSPLinKernighan::solve(std::chrono::steady_clock::time_point until) {
+    if (!inst.hasNeighborLists()) {
+        throw std::runtime_error("Lin-Kernighan needs the candidate lists of the instance");
+    }
+    auto start = std::chrono::steady_clock::now();
+    solve_start = start;
+    deadline = until;
+    time_limit_reached = false;
+    time_checks = 0;
+
+    // same starting tour of TSPHeuristic, read back from node 0 in one pass: node(i) is O(1) only for the array layout
+    tour = Tour(initial_tour.empty() ? buildTour(inst, construction) : initial_tour, layout);
+    std::vector<int> start_tour = tour.closedOrder();
+    obj_value = 0.0;
+    for (int i = 0; i < n; ++i) obj_value += inst.dist(start_tour[i], start_tour[i + 1]);
+    start_value = obj_value;
+    construction_time = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    if (incumbent_callback) incumbent_callback(construction_time, obj_value);
+
+    // every node starts active, without the repeated start node
+    start_tour.pop_back();
+    optimize(start_tour);
+    // the kicks of TSPIteratedLocalSearch call optimize() again without a deadline
+    deadline = std::chrono::steady_clock::time_point::max();
+
+    auto end = std::chrono::steady_clock::now();
+    solving_time = std::chrono::duration<double>(end - start).count();
+}
+
+// don't-look bits: a node is searched again only after one of its tour edges has changed
+// the queue is empty again on return, so every flag of `queued` is back to 0 and the next call costs only
+// the nodes it actually visits; at the deadline the nodes still queued are dropped
+void TSPLinKernighan::optimize(const std::vector<int>& nodes) {
+    queued.resize(n, 0);
+    for (int v : nodes) {
+        if (!queued[v]) {
+            queued[v] = 1;
+            queue.push_back(v);
+        }
+    }
+    while (!queue.empty()) {
+        if (outOfTime()) {
+            for (int v : queue) queued[v] = 0;
+            queue.clear();
+            break;
+        }
+        int v = queue.front();
+        queue.pop_front();
+        queued[v] = 0;
+
+        while (improveFrom(v)) {
+            if (journaling) journal.insert(journal.end(), flips.begin(), flips.end());
+            if (incumbent_callback) {
+                incumbent_callback(std::chrono::duration<double>(std::chrono::steady_clock::now() - solve_start).count(),
+                                   obj_value);
+            }
+            for (int u : touched) {
+                if (!queued[u]) {
+                    queued[u] = 1;
+                    queue.push_back(u);
+                }
+            }
+        }
+    }
+}
+
+void TSPLinKernighan::loadTour(const std::vector<int>& closed_tour) {
+    tour = Tour(closed_tour, layout);
+    std::vector<int> order = tour.closedOrder();
+    obj_value = 0.0;
+    for (int i = 0; i < n; ++i) obj_value += inst.dist(order[i], order[i + 1]);
+}
+
+// reverse the nodes at indices l .. r of the tour and record it so that the trial can be rolled back
+void TSPLinKernighan::reverseRange(int l, int r) {
+    int from = tour.node(l), to = tour.node(r);
+    tour.flip(from, to);
+    if (journaling) journal.push_back({from, to});
+}
+
+// the tour a B C d... becomes a C B d...: the three edges (a, b1), (b2, c1), (c2, d) are replaced by
+// (a, c1), (c2, b1), (b2, d), a move that no sequence of 2-opt moves undoes easily.
+// B C is reversed as a whole and then each of its halves, so only first + 1 .. first + len_b + len_c is touched
+std::vector<int> TSPLinKernighan::doubleBridge(int first, int len_b, int len_c) {
+    int last = first + len_b + len_c;
+    int a = tour.node(first), b1 = tour.node(first + 1), b2 = tour.node(first + len_b);
+    int c1 = tour.node(first + len_b + 1), c2 = tour.node(last), d = tour.node(last + 1);
+    obj_value += inst.dist(a, c1) + inst.dist(c2, b1) + inst.dist(b2, d)
+               - inst.dist(a, b1) - inst.dist(b2, c1) - inst.dist(c2, d);
+
+    reverseRange(first + 1, last);
+    reverseRange(first + 1, first + len_c);
+    reverseRange(first + len_c + 1, last);
+    return {a, b1, b2, c1, c2, d};
+}
+
+void TSPLinKernighan::beginTrial() {
+    journal.clear();
+    journaling = true;
+    trial_value = obj_value;
+}
+
+void TSPLinKernighan::commitTrial() {
+    journal.clear();
+    journaling = false;
+}
+
+// every flip is undone by flipping its path back, in reverse order
+void TSPLinKernighan::rollbackTrial() {
+    for (auto it = journal.rbegin(); it != journal.rend(); ++it) tour.flip(it->to, it->from);
+    journal.clear();
+    journaling = false;
+    obj_value = trial_value;
+}
+
+void TSPLinKernighan::setMaxDepth(int depth)
+{
+    max_depth = depth;
+}
+
+void TSPLinKernighan::setBreadth(int first_level, int second_level)
+{
+    breadth[0] = first_level;
+    breadth[1] = second_level;
+}
+
+void TSPLinKernighan::setConstruction(Construction method)
+{
+    construction = method;
+}
+
+void TSPLinKernighan::setStartTour(std::vector<int> closed_tour)
+{
+    initial_tour = std::move(closed_tour);
+}
+
+void TSPLinKernighan::setTourLayout(Tour::Layout tour_layout)
+{
+    layout = tour_layout;
+}
+
+void TSPLinKernighan::setIncumbentCallback(IncumbentCallback callback)
+{
+    incumbent_callback = std::move(callback);
+}
+
+double TSPLinKernighan::getObjValue() const
+{
+    return obj_value;
+}
+
+double TSPLinKernighan::getSolvingTime() const
+{
+    return solving_time;
+}
+
+double TSPLinKernighan::getStartValue() const
+{
+    return start_value;
+}
+
+double TSPLinKernighan::getConstructionTime() const
+{
+    return construction_time;
+}
+
+bool TSPLinKernighan::getTimeLimitReached() const
+{
+    return time_limit_reached;
+}
+
+// tour starting and ending at node 0, as for TSPHeuristic
+std::vector<int> TSPLinKernighan::getTour() const
+{
+    return tour.closedOrder();
+}
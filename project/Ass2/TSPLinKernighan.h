@@ -0,0 +1,109 @@
+#ifndef TSPLINKERNIGHAN_H
+#define TSPLINKERNIGHAN_H
+
+#include "TSPInstance.h"
+#include "TSPConstruction.h"
+#include "Tour.h"
+#include <vector>
+#include <chrono>
+#include <deque>
+#include <functional>
+
+// Lin-Kernighan style variable-depth local search
+// each move is a chain of sequential 2-opt exchanges t1-t2, t2-t3, t3-t4, ... grown while the partial gain stays
+// positive; new edges are only taken from the candidate lists of the instance, which must have been built
+class TSPLinKernighan {
+public:
+    // called with the seconds since the start of solve() and the new objective value whenever the tour improves
+    using IncumbentCallback = std::function<void(double elapsed, double objective)>;
+
+    explicit TSPLinKernighan(const TSPInstance& instance);
+
+    // maximum number of exchanges in a single move
+    void setMaxDepth(int depth);
+    // number of alternatives tried at the first levels of the chain before settling on the best one
+    void setBreadth(int first_level, int second_level);
+    // how the starting tour is built (TSPConstruction.h), greedy by default
+    void setConstruction(Construction method);
+    // start from this closed tour instead of building one, as TSPHeuristic::setStartTour
+    void setStartTour(std::vector<int> closed_tour);
+    // how the tour is stored (Tour.h), chosen from the size of the instance by default
+    void setTourLayout(Tour::Layout tour_layout);
+    void setIncumbentCallback(IncumbentCallback callback);
+    void solve();
+    // anytime version: the descent stops at the deadline and keeps the best tour found so far
+    void solve(std::chrono::steady_clock::time_point deadline);
+
+    double getObjValue() const;
+    double getSolvingTime() const;
+    double getStartValue() const;
+    double getConstructionTime() const;
+    // solve() stopped at the deadline instead of a local optimum
+    bool getTimeLimitReached() const;
+    std::vector<int> getTour() const;
+
+    // building blocks of the iterated local search (TSPIteratedLocalSearch.cpp), usable once the instance has candidate lists
+    // replace the current tour with a closed tour as returned by getTour()
+    void loadTour(const std::vector<int>& closed_tour);
+    // Lin-Kernighan descent where only `nodes` start active
+    void optimize(const std::vector<int>& nodes);
+    // double-bridge kick on the segments first+1 .. first+len_b and the len_c nodes after it, which must end
+    // before the end of the tour array; returns the endpoints of the changed edges
+    std::vector<int> doubleBridge(int first, int len_b, int len_c);
+    // every change after beginTrial() is recorded, and rollbackTrial() brings back the tour of that moment
+    void beginTrial();
+    void commitTrial();
+    void rollbackTrial();
+
+private:
+    const TSPInstance& inst;
+    int n;
+
+    Tour tour;
+    double obj_value;
+    double solving_time;
+    Construction construction;
+    std::vector<int> initial_tour;
+    double start_value;
+    double construction_time;
+    Tour::Layout layout;
+
+    int max_depth;
+    int breadth[2];
+
+    // state of the move being built from t1
+    struct Flip {
+        int from, to;   // reversed path, from `from` to `to` following succ
+    };
+    int t1;
+    std::vector<Flip> flips;
+    std::vector<std::pair<int, int>> added;     // edges added by the current move, never removed again
+    std::vector<int> touched;                   // endpoints of the exchanged edges
+
+    IncumbentCallback incumbent_callback;
+    std::chrono::steady_clock::time_point solve_start;
+    std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::time_point::max();
+    bool time_limit_reached = false;
+    unsigned time_checks = 0;
+
+    // don't-look bits queue of optimize()
+    std::deque<int> queue;
+    std::vector<char> queued;
+
+    // flips applied since beginTrial(), oldest first
+    bool journaling = false;
+    std::vector<Flip> journal;
+    double trial_value = 0.0;
+
+    int succ(int v) const;
+    int pred(int v) const;
+    void flip(int from, int to);
+    void undoFlip();
+    void reverseRange(int l, int r);
+    bool outOfTime();
+    bool wasAdded(int a, int b) const;
+    bool step(int level, int t2, double gain);
+    bool improveFrom(int v);
+};
+
+#endif
@@ -0,0 +1,409 @@
+#include "TSPLowerBound.h"
+#include "SpatialGrid.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+// the step size is halved after this many 1-trees without a better bound, and the ascent stops once it is tiny
+static const int HALVING_PERIOD = 10;
+static const double MIN_STEP_SCALE = 1e-3;
+// up to this size the ascent runs on the complete graph
+static const int DENSE_MAX_NODES = 200;
+
+static const double INF = std::numeric_limits<double>::infinity();
+
+namespace {
+
+// binary min-heap of nodes on their keys with decrease-key: each node is in it at most once, so Prim makes n pops
+// instead of one per relaxed edge
+class NodeHeap {
+public:
+    NodeHeap(const std::vector<double>& key, int n):key(key),pos(n, -1) {}
+
+    bool empty() const { return heap.empty(); }
+    int top() const { return heap[0]; }
+    // insert v, or move it up after its key decreased
+    void update(int v) {
+        if (pos[v] < 0) {
+            pos[v] = (int)heap.size();
+            heap.push_back(v);
+        }
+        up(pos[v]);
+    }
+    int pop() {
+        int top = heap[0];
+        pos[top] = -2;
+        int last = heap.back();
+        heap.pop_back();
+        if (!heap.empty()) {
+            heap[0] = last;
+            pos[last] = 0;
+            down(0);
+        }
+        return top;
+    }
+
+private:
+    const std::vector<double>& key;
+    std::vector<int> pos;   // index of each node in heap, -1 never inserted, -2 popped
+    std::vector<int> heap;
+
+    void place(int i, int v) {
+        heap[i] = v;
+        pos[v] = i;
+    }
+    void up(int i) {
+        int v = heap[i];
+        while (i > 0 && key[heap[(i - 1) / 2]] > key[v]) {
+            place(i, heap[(i - 1) / 2]);
+            i = (i - 1) / 2;
+        }
+        place(i, v);
+    }
+    void down(int i) {
+        int v = heap[i];
+        int size = (int)heap.size();
+        while (true) {
+            int c = 2 * i + 1;
+            if (c >= size) break;
+            if (c + 1 < size && key[heap[c + 1]] < key[heap[c]]) c++;
+            if (key[heap[c]] >= key[v]) break;
+            place(i, heap[c]);
+            i = c;
+        }
+        place(i, v);
+    }
+};
+
+}
+
+TSPLowerBound::TSPLowerBound(const TSPInstance& instance):inst(instance),n(instance.n),upper_bound(0.0),max_iterations(300),candidates(10),time_limit(0.0),bound(0.0),proven(false),exact(false),iterations(0),time_limit_reached(false),solving_time(0.0) {}
+
+// quadrant nearest nodes of every node, made symmetric: an edge of the list of i or of j is an edge of both
+void TSPLowerBound::buildCandidateGraph() {
+    SpatialGrid grid(n, inst.xs, inst.ys);
+    std::vector<int> near_start(n + 1, 0);
+    std::vector<int> near;
+    near.reserve((size_t)n * candidates);
+    for (int i = 0; i < n; ++i) {
+        for (int j : grid.quadrantNearest(i, candidates)) near.push_back(j);
+        near_start[i + 1] = (int)near.size();
+    }
+
+    std::vector<int> start(n + 1, 0);
+    for (int i = 0; i < n; ++i) {
+        for (int k = near_start[i]; k < near_start[i + 1]; ++k) {
+            start[i + 1]++;
+            start[near[k] + 1]++;
+        }
+    }
+    for (int i = 0; i < n; ++i) start[i + 1] += start[i];
+    std::vector<int> all(start[n]);
+    std::vector<int> fill(start.begin(), start.end() - 1);
+    for (int i = 0; i < n; ++i) {
+        for (int k = near_start[i]; k < near_start[i + 1]; ++k) {
+            all[fill[i]++] = near[k];
+            all[fill[near[k]]++] = i;
+        }
+    }
+
+    // an edge listed by both endpoints appears twice
+    adj_start.assign(n + 1, 0);
+    adj.clear();
+    adj.reserve(all.size());
+    for (int i = 0; i < n; ++i) {
+        auto first = all.begin() + start[i], last = all.begin() + start[i + 1];
+        std::sort(first, last);
+        adj.insert(adj.end(), first, std::unique(first, last));
+        adj_start[i + 1] = (int)adj.size();
+    }
+    // the distances are read once per 1-tree for every edge, they are worth keeping
+    adj_dist.resize(adj.size());
+    for (int i = 0; i < n; ++i) {
+        for (int a = adj_start[i]; a < adj_start[i + 1]; ++a) adj_dist[a] = inst.dist(i, adj[a]);
+    }
+
+    // for the bounded edges: the nearest node outside the candidates of i is among its degree + 1 nearest nodes. The
+    // rounded TSPLIB distances grow with the Euclidean one, but a GEO distance does not follow the coordinates: 0 is
+    // all it gets
+    reach.assign(n, INF);
+    for (int i = 0; n > EXACT_MAX_NODES && i < n; ++i) {
+        if (inst.metric == TSPInstance::Metric::Geo) {
+            reach[i] = 0.0;
+            continue;
+        }
+        auto first = adj.begin() + adj_start[i], last = adj.begin() + adj_start[i + 1];
+        for (int j : grid.kNearest(i, adj_start[i + 1] - adj_start[i] + 1)) {
+            if (!std::binary_search(first, last, j)) reach[i] = std::min(reach[i], inst.dist(i, j));
+        }
+    }
+}
+
+// Prim on the candidate graph, O(m log n). With bounded_edges, an edge (i,j) outside it is at least as long as
+// reach[i] and reach[j], so its weight under the penalties is at least r[i] + r[j] with r[v] = reach[v] / 2 + p[v]:
+// these edges are kept with that weight, and a node joins the tree through them at r[v] plus the smallest r of the
+// tree. The 1-tree of this graph weighs no more than the one of the complete graph, and the graph is connected even
+// when the candidate graph falls apart into clusters
+bool TSPLowerBound::sparseOneTree(const std::vector<double>& p, bool bounded_edges, double& w) {
+    std::vector<double> key(n, INF);
+    std::vector<int> parent(n, -1);
+    std::vector<char> in_tree(n, 0);
+    NodeHeap heap(key, n);
+
+    // nodes 1..n-1 by increasing r, the tree nodes are skipped
+    std::vector<double> r;
+    std::vector<int> by_r;
+    if (bounded_edges) {
+        r.resize(n);
+        for (int v = 0; v < n; ++v) r[v] = 0.5 * reach[v] + p[v];
+        by_r.resize(n - 1);
+        for (int v = 1; v < n; ++v) by_r[v - 1] = v;
+        std::sort(by_r.begin(), by_r.end(), [&](int u, int v) { return r[u] < r[v]; });
+    }
+    size_t next_r = 0;
+    int tree_r = -1;    // node of the tree with the smallest r
+
+    degree.assign(n, 0);
+    w = 0.0;
+    key[1] = 0.0;
+    heap.update(1);
+    for (int step = 1; step < n; ++step) {
+        // a node that joined through a bounded edge is still in the heap
+        while (!heap.empty() && in_tree[heap.top()]) heap.pop();
+        while (next_r < by_r.size() && in_tree[by_r[next_r]]) next_r++;
+        double candidate = heap.empty() ? INF : key[heap.top()];
+        double bounded = tree_r < 0 || next_r == by_r.size() ? INF : r[tree_r] + r[by_r[next_r]];
+        if (candidate == INF && bounded == INF) return false;
+        int u, from;
+        if (candidate <= bounded) {
+            u = heap.pop();
+            from = parent[u];
+            w += candidate;
+        } else {
+            u = by_r[next_r];
+            from = tree_r;
+            w += bounded;
+        }
+        in_tree[u] = 1;
+        if (from >= 0) {
+            degree[u]++;
+            degree[from]++;
+        }
+        if (bounded_edges && (tree_r < 0 || r[u] < r[tree_r])) tree_r = u;
+        for (int a = adj_start[u]; a < adj_start[u + 1]; ++a) {
+            int v = adj[a];
+            if (v == 0 || in_tree[v]) continue;
+            double c = adj_dist[a] + p[u] + p[v];
+            if (c < key[v]) {
+                key[v] = c;
+                parent[v] = u;
+                heap.update(v);
+            }
+        }
+    }
+
+    // the two cheapest edges of node 0, candidate or bounded; the bounded ones go to the nodes of smallest r
+    int a = -1, b = -1;
+    double ca = INF, cb = INF;
+    auto offer = [&](int v, double c) {
+        if (c < ca) {
+            b = a;
+            cb = ca;
+            a = v;
+            ca = c;
+        } else if (c < cb) {
+            b = v;
+            cb = c;
+        }
+    };
+    for (int e = adj_start[0]; e < adj_start[1]; ++e) offer(adj[e], adj_dist[e] + p[0] + p[adj[e]]);
+    for (size_t k = 0; k < 2 && k < by_r.size(); ++k) offer(by_r[k], r[0] + r[by_r[k]]);
+    if (b < 0) return false;
+    w += ca + cb;
+    degree[0] = 2;
+    degree[a]++;
+    degree[b]++;
+    for (int i = 0; i < n; ++i) w -= 2.0 * p[i];
+    return true;
+}
+
+// Prim on the complete graph with an array of keys, O(n^2)
+double TSPLowerBound::denseOneTree(const std::vector<double>& p) {
+    std::vector<double> key(n, INF);
+    std::vector<int> parent(n, -1);
+    std::vector<char> in_tree(n, 0);
+
+    degree.assign(n, 0);
+    double w = 0.0;
+    key[1] = 0.0;
+    for (int step = 1; step < n; ++step) {
+        int u = -1;
+        for (int v = 1; v < n; ++v) {
+            if (!in_tree[v] && (u < 0 || key[v] < key[u])) u = v;
+        }
+        in_tree[u] = 1;
+        w += key[u];
+        if (parent[u] >= 0) {
+            degree[u]++;
+            degree[parent[u]]++;
+        }
+        for (int v = 1; v < n; ++v) {
+            if (in_tree[v]) continue;
+            double c = inst.dist(u, v) + p[u] + p[v];
+            if (c < key[v]) {
+                key[v] = c;
+                parent[v] = u;
+            }
+        }
+    }
+
+    int a = -1, b = -1;
+    double ca = INF, cb = INF;
+    for (int v = 1; v < n; ++v) {
+        double c = inst.dist(0, v) + p[0] + p[v];
+        if (c < ca) {
+            b = a;
+            cb = ca;
+            a = v;
+            ca = c;
+        } else if (c < cb) {
+            b = v;
+            cb = c;
+        }
+    }
+    w += ca + cb;
+    degree[0] = 2;
+    degree[a]++;
+    degree[b]++;
+    for (int i = 0; i < n; ++i) w -= 2.0 * p[i];
+    return w;
+}
+
+// subgradient ascent with the step of Held, Wolfe and Crowder: t = lambda (U - w) / |d - 2|^2, where U is the
+// length of a tour and lambda starts at 2 and is halved whenever the bound stops improving
+void TSPLowerBound::solve() {
+    if (upper_bound <= 0.0) {
+        throw std::runtime_error("The lower bound needs the length of a tour");
+    }
+    auto start = std::chrono::steady_clock::now();
+    auto deadline = start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                                std::chrono::duration<double>(time_limit));
+    pi.assign(n, 0.0);
+    iterations = 0;
+    time_limit_reached = false;
+    proven = true;
+    exact = true;
+    if (n < 3) {
+        bound = n == 2 ? 2.0 * inst.dist(0, 1) : 0.0;
+        solving_time = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        return;
+    }
+
+    // an EXPLICIT instance has no coordinates to find its candidates
+    bool sparse = inst.hasCoordinates() && n > DENSE_MAX_NODES;
+    if (sparse) buildCandidateGraph();
+    // above EXACT_MAX_NODES the complete graph is out of reach, the edges outside the candidate graph take part in the
+    // ascent with their bounded weight so that its 1-trees are valid bounds. Below, the ascent is better off without
+    // them: a node of very negative penalty becomes a hub of bounded edges and pulls the 1-trees away from tours
+    bool bounded_edges = sparse && n > EXACT_MAX_NODES;
+
+    std::vector<double> p(n, 0.0);
+    double best = -INF;
+    double lambda = 2.0;
+    int since_improved = 0;
+    while (iterations < max_iterations) {
+        // every penalty vector gives a valid bound, stopping early only makes it weaker
+        if (time_limit > 0.0 && iterations > 0 && std::chrono::steady_clock::now() >= deadline) {
+            time_limit_reached = true;
+            break;
+        }
+        double w = 0.0;
+        // the candidate graph falls apart (far away clusters): the complete graph, small enough without the bounded edges
+        if (sparse && !sparseOneTree(p, bounded_edges, w)) sparse = false;
+        if (!sparse) w = denseOneTree(p);
+        iterations++;
+
+        if (w > best) {
+            best = w;
+            pi = p;
+            since_improved = 0;
+        } else if (++since_improved >= HALVING_PERIOD) {
+            lambda /= 2.0;
+            since_improved = 0;
+            if (lambda < MIN_STEP_SCALE) break;
+        }
+
+        double norm = 0.0;
+        for (int i = 0; i < n; ++i) norm += (double)(degree[i] - 2) * (degree[i] - 2);
+        // a 1-tree with all degrees 2 is a tour, and nothing is left to gain once the bound meets the tour
+        if (norm == 0.0 || w >= upper_bound) break;
+        double t = lambda * (upper_bound - w) / norm;
+        for (int i = 0; i < n; ++i) p[i] += t * (degree[i] - 2);
+    }
+
+    bound = best;
+    exact = !bounded_edges;
+    if (sparse && exact) bound = denseOneTree(pi);
+    // rounded distances make every tour length an integer
+    if (inst.metric != TSPInstance::Metric::Euclidean && inst.metric != TSPInstance::Metric::Explicit) {
+        bound = std::ceil(bound - 1e-6);
+    }
+    solving_time = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+void TSPLowerBound::setUpperBound(double value)
+{
+    upper_bound = value;
+}
+
+void TSPLowerBound::setMaxIterations(int count)
+{
+    max_iterations = count;
+}
+
+void TSPLowerBound::setTimeLimit(double seconds)
+{
+    time_limit = seconds;
+}
+
+void TSPLowerBound::setCandidates(int k)
+{
+    candidates = k;
+}
+
+double TSPLowerBound::getBound() const
+{
+    return bound;
+}
+
+bool TSPLowerBound::getProven() const
+{
+    return proven;
+}
+
+bool TSPLowerBound::getExact() const
+{
+    return exact;
+}
+
+int TSPLowerBound::getIterations() const
+{
+    return iterations;
+}
+
+bool TSPLowerBound::getTimeLimitReached() const
+{
+    return time_limit_reached;
+}
+
+double TSPLowerBound::getSolvingTime() const
+{
+    return solving_time;
+}
+
+const std::vector<double>& TSPLowerBound::getPenalties() const
+{
+    return pi;
+}
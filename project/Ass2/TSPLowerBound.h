@@ -0,0 +1,77 @@
+#ifndef TSPLOWERBOUND_H
+#define TSPLOWERBOUND_H
+
+#include "TSPInstance.h"
+#include <vector>
+
+// Held-Karp lower bound: the best 1-tree (a spanning tree of nodes 1..n-1 plus the two cheapest edges of node 0)
+// under the edge weights d(i,j) + pi[i] + pi[j], minus 2 sum(pi), with the penalties pi found by subgradient ascent.
+// A tour is a 1-tree, so every pi gives a bound; nodes of degree above 2 in the 1-tree are made more expensive and
+// leaves cheaper until the 1-tree looks like a tour.
+// Above a few hundred nodes the ascent computes its minimum spanning trees on a sparse candidate graph (the quadrant
+// nearest nodes), so it scales to large instances; the bound of the best penalties is then computed again on the
+// complete graph up to EXACT_MAX_NODES nodes. Above, the edges outside the candidate graph take part in the ascent
+// with a lower bound of their weight (see sparseOneTree): its 1-trees are valid bounds, a little weaker
+class TSPLowerBound {
+public:
+    static const int EXACT_MAX_NODES = 10000;
+
+    explicit TSPLowerBound(const TSPInstance& instance);
+
+    // length of a known tour, the target of the step size: required
+    void setUpperBound(double value);
+    // 1-trees computed at most
+    void setMaxIterations(int iterations);
+    // seconds of the ascent, 0 = no limit; the bound of the best penalties so far is kept, and up to EXACT_MAX_NODES
+    // nodes its final evaluation on the complete graph, O(n^2), still follows
+    void setTimeLimit(double seconds);
+    // nearest nodes of each node in the candidate graph
+    void setCandidates(int k);
+    void solve();
+
+    double getBound() const;
+    // solve() gave a bound that is at most the optimum, whatever the size of the instance
+    bool getProven() const;
+    // the bound of the best penalties was computed on the complete graph, the tightest they give
+    bool getExact() const;
+    int getIterations() const;
+    // the ascent stopped at the time limit, the bound is valid but weaker
+    bool getTimeLimitReached() const;
+    double getSolvingTime() const;
+    // penalties of the best bound, e.g. to rank candidate edges by alpha-nearness
+    const std::vector<double>& getPenalties() const;
+
+private:
+    const TSPInstance& inst;
+    int n;
+
+    double upper_bound;
+    int max_iterations;
+    int candidates;
+    double time_limit;
+
+    double bound;
+    bool proven;
+    bool exact;
+    int iterations;
+    bool time_limit_reached;
+    double solving_time;
+    std::vector<double> pi;
+
+    // symmetric candidate graph: the neighbors of i are adj[adj_start[i] .. adj_start[i + 1])
+    std::vector<int> adj_start;
+    std::vector<int> adj;
+    std::vector<double> adj_dist;
+    // distance from each node to its nearest node outside its candidates, infinite if it has none
+    std::vector<double> reach;
+
+    std::vector<int> degree;
+
+    void buildCandidateGraph();
+    // weight of the 1-tree under penalties p minus 2 sum(p), with the degrees of its nodes; on the candidate graph
+    // alone false if it does not connect all the nodes, never with the bounded edges
+    bool sparseOneTree(const std::vector<double>& p, bool bounded_edges, double& w);
+    double denseOneTree(const std::vector<double>& p);
+};
+
+#endif
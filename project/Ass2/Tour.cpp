@@ -0,0 +1,64 @@
+#include "Tour.h"
+#include <utility>
+
+Tour::Tour(const std::vector<int>& nodes, Layout tour_layout) {
+    n = (int)nodes.size();
+    if (n > 1 && nodes.front() == nodes.back()) n--;
+    layout = tour_layout;
+    if (layout == Layout::Auto) {
+        layout = n <= MAX_ARRAY_NODES ? Layout::Array : Layout::TwoLevel;
+    }
+    if (layout == Layout::TwoLevel) {
+        list = TwoLevelList(std::vector<int>(nodes.begin(), nodes.begin() + n));
+        return;
+    }
+    order.assign(nodes.begin(), nodes.begin() + n);
+    pos.assign(n, 0);
+    for (int p = 0; p < n; ++p) pos[order[p]] = p;
+}
+
+// reverse the `count` entries of order starting at `first` and wrapping around the end of the array
+void Tour::reverseCyclic(int first, int count) {
+    int l = first, r = first + count - 1;
+    if (r >= n) r -= n;
+    STATS(moved += count / 2 * 2;)
+    for (int s = 0; s < count / 2; ++s) {
+        std::swap(order[l], order[r]);
+        pos[order[l]] = l;
+        pos[order[r]] = r;
+        if (++l == n) l = 0;
+        if (--r < 0) r = n - 1;
+    }
+}
+
+void Tour::flip(int a, int b) {
+    STATS(reversals++;)
+    if (layout == Layout::TwoLevel) {
+        list.flip(a, b);
+        return;
+    }
+    int len = index(b) - index(a);
+    if (len < 0) len += n;
+    len++;
+    if (2 * len <= n) {
+        // the path itself is the shorter side: in the array it starts at a, or at b when read backwards
+        reverseCyclic(reversed ? pos[b] : pos[a], len);
+    } else {
+        // reverse the complement next(b) .. prev(a) and read the tour the other way round
+        int first = reversed ? pos[prev(a)] : pos[next(b)];
+        reverseCyclic(first, n - len);
+        reversed = !reversed;
+    }
+}
+
+std::vector<int> Tour::closedOrder() const {
+    std::vector<int> closed;
+    closed.reserve(n + 1);
+    if (layout == Layout::TwoLevel) {
+        // walked with next(), node(i) would cost O(sqrt(n)) each
+        for (int i = 0, v = 0; i <= n; ++i, v = list.next(v)) closed.push_back(v);
+        return closed;
+    }
+    for (int i = 0; i <= n; ++i) closed.push_back(node(i));
+    return closed;
+}
@@ -0,0 +1,90 @@
+#ifndef TOUR_H
+#define TOUR_H
+
+#include "TwoLevelList.h"
+#include "SearchStats.h"
+#include <vector>
+
+// cyclic tour kept as the array of its nodes plus the position of each node in that array
+// the tour is read from node 0 in the current orientation: node(i) is the node i steps after node 0 and index(v)
+// the number of steps from node 0 to v, so that node(0) == node(n) == 0 as in the closed tours of TSPConstruction.h.
+// Reversals flip whichever of the segment and its complement is shorter: flipping the complement and switching
+// the orientation leaves the same sequence from node 0, so callers never see which side was moved.
+// With the TwoLevel layout the same interface is served by a TwoLevelList: next/prev/between stay O(1) and flips cost
+// O(sqrt(n)) instead of O(n), but node(i) and index(v) cost O(sqrt(n)) too, so it only suits searches that move
+// along next/prev (TSPLinKernighan) on large instances
+class Tour {
+public:
+    enum class Layout {
+        Array,
+        TwoLevel,
+        Auto        // array up to MAX_ARRAY_NODES nodes, two-level list above
+    };
+    static const int MAX_ARRAY_NODES = 5000;
+
+    Tour() = default;
+    // closed tour (first node repeated at the end) or plain order of the n nodes
+    explicit Tour(const std::vector<int>& order, Layout layout = Layout::Array);
+
+    int size() const { return n; }
+
+    // i in [0, n]
+    int node(int i) const {
+        if (layout == Layout::TwoLevel) return list.node(i);
+        int p = reversed ? anchor() - i : anchor() + i;
+        if (p >= n) p -= n;
+        if (p < 0) p += n;
+        return order[p];
+    }
+    int index(int v) const {
+        if (layout == Layout::TwoLevel) return list.index(v);
+        int d = reversed ? anchor() - pos[v] : pos[v] - anchor();
+        return d < 0 ? d + n : d;
+    }
+    int next(int v) const {
+        if (layout == Layout::TwoLevel) return list.next(v);
+        int p = reversed ? pos[v] - 1 : pos[v] + 1;
+        return order[p == n ? 0 : (p < 0 ? n - 1 : p)];
+    }
+    int prev(int v) const {
+        if (layout == Layout::TwoLevel) return list.prev(v);
+        int p = reversed ? pos[v] + 1 : pos[v] - 1;
+        return order[p == n ? 0 : (p < 0 ? n - 1 : p)];
+    }
+    // true if b is met going from a to c with next(), a and c included
+    bool between(int a, int b, int c) const {
+        if (layout == Layout::TwoLevel) return list.between(a, b, c);
+        int ia = index(a);
+        int ab = index(b) - ia, ac = index(c) - ia;
+        if (ab < 0) ab += n;
+        if (ac < 0) ac += n;
+        return ab <= ac;
+    }
+
+    // reverse the path from a to b following next()
+    void flip(int a, int b);
+    // reverse the nodes node(i) .. node(j), 0 < i <= j < n: node 0 never moves
+    void reverse(int i, int j) { flip(node(i), node(j)); }
+
+    // nodes from node 0 with node 0 repeated at the end
+    std::vector<int> closedOrder() const;
+
+    // flips and array entries rewritten by them since construction, counted only with TSP_STATS (SearchStats.h)
+    long long reversalCount() const { return reversals; }
+    long long movedCount() const { return moved; }
+
+private:
+    int n = 0;
+    Layout layout = Layout::Array;
+    TwoLevelList list;
+    std::vector<int> order;
+    std::vector<int> pos;   // pos[v] = index of node v in order
+    bool reversed = false;  // the tour is read backwards in order
+    long long reversals = 0;
+    long long moved = 0;
+
+    int anchor() const { return pos[0]; }
+    void reverseCyclic(int first, int count);
+};
+
+#endif
@@ -0,0 +1,244 @@
+#include "TourCache.h"
+#include "InstanceFile.h"
+#include "SpatialGrid.h"
+#include <algorithm>
+#include <cmath>
+#include <filesystem>
+#include <iomanip>
+#include <sstream>
+#include <stdexcept>
+
+namespace fs = std::filesystem;
+
+// a line of index.csv is: hash,n,obj_value,<SIGNATURE_SIZE hex values separated by spaces>
+TourCache::TourCache(const std::string& name):folder(name) {
+    fs::create_directories(folder);
+    std::string index_name = folder + "/index.csv";
+    std::ifstream fin(index_name);
+    std::string line;
+    bool ends_with_newline = true;
+    while (std::getline(fin, line)) {
+        ends_with_newline = !fin.eof();
+        // the last line of a run killed while writing it is incomplete
+        if (!ends_with_newline) continue;
+        std::replace(line.begin(), line.end(), ',', ' ');
+        std::istringstream ss(line);
+        Entry entry;
+        ss >> std::hex >> entry.hash >> std::dec >> entry.n >> entry.obj_value >> std::hex;
+        for (uint64_t& h : entry.signature) ss >> h;
+        if (!ss) continue;
+        entries[entry.hash] = entry;
+    }
+    fin.close();
+
+    index.open(index_name, std::ios::app);
+    if (!index.is_open()) {
+        throw std::runtime_error("Cannot open tour cache " + index_name);
+    }
+    if (!ends_with_newline) index << "\n";
+}
+
+std::string TourCache::tourFile(uint64_t hash) const {
+    std::ostringstream name;
+    name << folder << "/" << std::hex << std::setw(16) << std::setfill('0') << hash << ".tour";
+    return name.str();
+}
+
+// MinHash of the set of points: slot s keeps the smallest of the hashes of the points mixed with seed s, so two
+// instances agree on a slot with probability |A and B| / |A or B|. A point is hashed from the bytes of its
+// coordinates, only the nodes that did not move count as shared
+TourCache::Signature TourCache::signature(const TSPInstance& inst) {
+    Signature sig;
+    sig.fill(UINT64_MAX);
+    for (int v = 0; v < inst.n; ++v) {
+        uint64_t point = fnv1a(&inst.ys[v], sizeof(double), fnv1a(&inst.xs[v], sizeof(double)));
+        for (int s = 0; s < SIGNATURE_SIZE; ++s) {
+            // splitmix64 finalizer
+            uint64_t h = point + (uint64_t)(s + 1) * 0x9E3779B97F4A7C15ULL;
+            h = (h ^ (h >> 30)) * 0xBF58476D1CE4E5B9ULL;
+            h = (h ^ (h >> 27)) * 0x94D049BB133111EBULL;
+            h ^= h >> 31;
+            sig[s] = std::min(sig[s], h);
+        }
+    }
+    return sig;
+}
+
+TourCache::Start TourCache::startTour(const TSPInstance& inst) const {
+    if (!inst.hasCoordinates()) return Start();
+    Entry best;
+    bool found = false;
+    {
+        std::lock_guard<std::mutex> lock(m);
+        auto it = entries.find(inst.content_hash);
+        if (it != entries.end()) {
+            best = it->second;
+            found = true;
+        }
+    }
+    if (!found) {
+        // at least half of the slots in common: about half of the points shared
+        Signature sig = signature(inst);
+        int best_equal = SIGNATURE_SIZE / 2 - 1;
+        std::lock_guard<std::mutex> lock(m);
+        for (const auto& [hash, entry] : entries) {
+            int equal = 0;
+            for (int s = 0; s < SIGNATURE_SIZE; ++s) equal += entry.signature[s] == sig[s];
+            if (equal > best_equal) {
+                best = entry;
+                best_equal = equal;
+                found = true;
+            }
+        }
+    }
+    if (!found) return Start();
+
+    // the tour files are replaced by a rename, a file being read is never half written
+    std::ifstream fin(tourFile(best.hash), std::ios::binary);
+    int32_t count = 0;
+    fin.read(reinterpret_cast<char*>(&count), sizeof(count));
+    if (!fin || count != best.n) return Start();
+    std::vector<double> cx(count), cy(count);
+    fin.read(reinterpret_cast<char*>(cx.data()), count * sizeof(double));
+    fin.read(reinterpret_cast<char*>(cy.data()), count * sizeof(double));
+    if (!fin) return Start();
+    return adapt(inst, cx, cy);
+}
+
+TourCache::Start TourCache::adapt(const TSPInstance& inst, const std::vector<double>& cx, const std::vector<double>& cy) {
+    int n = inst.n;
+    int m = (int)cx.size();
+    Start start;
+
+    // a node moved by more than half the typical spacing between nodes counts as removed and added again
+    double w = *std::max_element(inst.xs, inst.xs + n) - *std::min_element(inst.xs, inst.xs + n);
+    double h = *std::max_element(inst.ys, inst.ys + n) - *std::min_element(inst.ys, inst.ys + n);
+    double radius = 0.5 * std::sqrt(std::max(w * h, std::max(w, h) * std::max(w, h) / n) / n);
+
+    // each node matches one point of the cached tour at most: matched nodes leave the grid
+    // the points still in place are matched first, so that a moved node cannot take the place of one that stayed
+    SpatialGrid grid(n, inst.xs, inst.ys);
+    std::vector<int> match(m, -1);
+    for (int p = 0; p < m; ++p) {
+        int v = grid.nearest(cx[p], cy[p], 0.0);
+        if (v < 0) continue;
+        match[p] = v;
+        grid.remove(v);
+    }
+    for (int p = 0; p < m; ++p) {
+        if (match[p] >= 0) continue;
+        int v = grid.nearest(cx[p], cy[p], radius);
+        if (v < 0) continue;
+        match[p] = v;
+        grid.remove(v);
+    }
+
+    // circular list of the matched nodes in the order of the cached tour
+    std::vector<int> next(n, -1), prev(n, -1);
+    int first = -1, last = -1;
+    for (int p = 0; p < m; ++p) {
+        int v = match[p];
+        if (v < 0) {
+            start.dropped++;
+            continue;
+        }
+        if (first < 0) {
+            first = v;
+        } else {
+            next[last] = v;
+            prev[v] = last;
+        }
+        last = v;
+        start.kept++;
+    }
+    // too different: the construction does better than inserting most of the nodes
+    if (start.kept < 2 || 2 * start.kept < n) return Start();
+    next[last] = first;
+    prev[first] = last;
+
+    // cheapest insertion of the new nodes, on the tour edges around their nearest nodes already in the tour;
+    // the whole tour is scanned only when none of them is
+    SpatialGrid near(n, inst.xs, inst.ys);
+    for (int u = 0; u < n; ++u) {
+        if (next[u] >= 0) continue;
+        int best_a = -1;
+        double best_delta = 0.0;
+        auto tryEdge = [&](int a) {
+            int b = next[a];
+            double delta = inst.dist(a, u) + inst.dist(u, b) - inst.dist(a, b);
+            if (best_a < 0 || delta < best_delta) {
+                best_a = a;
+                best_delta = delta;
+            }
+        };
+        for (int v : near.kNearest(u, 8)) {
+            if (next[v] < 0) continue;
+            tryEdge(v);
+            tryEdge(prev[v]);
+        }
+        if (best_a < 0) {
+            int a = first;
+            do {
+                tryEdge(a);
+                a = next[a];
+            } while (a != first);
+        }
+        int b = next[best_a];
+        next[best_a] = u;
+        prev[u] = best_a;
+        next[u] = b;
+        prev[b] = u;
+        start.inserted++;
+    }
+
+    start.tour.reserve(n + 1);
+    int v = 0;
+    do {
+        start.tour.push_back(v);
+        v = next[v];
+    } while (v != 0);
+    start.tour.push_back(0);
+    return start;
+}
+
+void TourCache::store(const TSPInstance& inst, const std::vector<int>& tour, double obj_value) {
+    if (!inst.hasCoordinates()) return;
+    int n = inst.n;
+    if ((int)tour.size() < n) {
+        throw std::runtime_error("The tour to cache does not visit every node");
+    }
+    Entry entry;
+    entry.hash = inst.content_hash;
+    entry.n = n;
+    entry.obj_value = obj_value;
+    entry.signature = signature(inst);
+
+    std::lock_guard<std::mutex> lock(m);
+    auto it = entries.find(entry.hash);
+    if (it != entries.end() && it->second.obj_value <= obj_value) return;
+
+    std::vector<double> cx(n), cy(n);
+    for (int i = 0; i < n; ++i) {
+        cx[i] = inst.xs[tour[i]];
+        cy[i] = inst.ys[tour[i]];
+    }
+    std::string name = tourFile(entry.hash);
+    std::string temp = name + ".tmp";
+    std::ofstream fout(temp, std::ios::binary | std::ios::trunc);
+    int32_t count = n;
+    fout.write(reinterpret_cast<const char*>(&count), sizeof(count));
+    fout.write(reinterpret_cast<const char*>(cx.data()), n * sizeof(double));
+    fout.write(reinterpret_cast<const char*>(cy.data()), n * sizeof(double));
+    fout.close();
+    if (!fout) {
+        throw std::runtime_error("Error writing the cached tour " + temp);
+    }
+    fs::rename(temp, name);
+
+    index << std::hex << std::setw(16) << std::setfill('0') << entry.hash << std::dec << "," << n << ","
+          << std::setprecision(17) << obj_value << "," << std::hex;
+    for (int s = 0; s < SIGNATURE_SIZE; ++s) index << (s ? " " : "") << entry.signature[s];
+    index << std::dec << "\n";
+    index.flush();
+    entries[entry.hash] = entry;
+}
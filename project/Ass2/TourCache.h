@@ -0,0 +1,60 @@
+#ifndef TOURCACHE_H
+#define TOURCACHE_H
+
+#include "TSPInstance.h"
+#include <array>
+#include <cstdint>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// best tours of the instances solved so far, kept across runs so that a revised instance (a few nodes moved, added
+// or removed) starts from the tour of its previous revision instead of a new construction.
+// The folder holds index.csv, one line per tour, and the tours themselves as <hash>.tour with the coordinates of
+// the nodes in tour order: an instance is matched by its content hash first, then by a MinHash signature of its
+// set of points, and the nodes of the cached tour are mapped to the new ones by their coordinates.
+// Only instances with coordinates are cached; the methods are thread safe
+class TourCache {
+public:
+    // starting tour adapted from the cache
+    struct Start {
+        std::vector<int> tour;  // closed tour from node 0, empty if no cached tour matches well enough
+        int kept = 0;           // nodes matched to a node of the cached tour, visited in its order
+        int inserted = 0;       // new nodes, added by cheapest insertion
+        int dropped = 0;        // nodes of the cached tour with no match, left out
+    };
+
+    // the tours already in the folder, created if needed
+    explicit TourCache(const std::string& folder);
+
+    // tour of the closest cached instance with the nodes of inst; the tour is empty when no instance shares at least
+    // half of its points with inst, or fewer than half of the nodes of inst are matched
+    Start startTour(const TSPInstance& inst) const;
+    // keep tour (closed or not) as the tour of inst, unless the cache has a shorter one for the same instance
+    void store(const TSPInstance& inst, const std::vector<int>& tour, double obj_value);
+
+private:
+    static const int SIGNATURE_SIZE = 32;
+    using Signature = std::array<uint64_t, SIGNATURE_SIZE>;
+
+    struct Entry {
+        uint64_t hash = 0;
+        int n = 0;
+        double obj_value = 0.0;
+        Signature signature;
+    };
+
+    std::string folder;
+    std::unordered_map<uint64_t, Entry> entries;
+    std::ofstream index;
+    mutable std::mutex m;
+
+    static Signature signature(const TSPInstance& inst);
+    std::string tourFile(uint64_t hash) const;
+    // map the cached tour (its coordinates in tour order) onto the nodes of inst
+    static Start adapt(const TSPInstance& inst, const std::vector<double>& cx, const std::vector<double>& cy);
+};
+
+#endif
@@ -0,0 +1,378 @@
+#include "TwoLevelList.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
+// sequence numbers are renumbered from 0 before they can overflow, pushes move them away from 0 one at a time
+static const int SEQ_LIMIT = 1 << 30;
+
+TwoLevelList::TwoLevelList(const std::vector<int>& order) {
+    n = (int)order.size();
+    segments = std::max(1, (int)std::sqrt((double)n));
+    group = n / segments;
+    nodes.assign(n, {0, 0, -1, -1});
+    segs.assign(segments, {-1, -1, 0, 0, 0, 0, false});
+
+    // consecutive nodes of the order in segments of n / segments nodes, sizes differing by at most one
+    for (int i = 0; i < n; ++i) {
+        int v = order[i];
+        int s = (int)((long long)i * segments / n);
+        nodes[v].parent = s;
+        nodes[v].seq = segs[s].count++;
+        if (segs[s].first < 0) {
+            segs[s].first = v;
+        } else {
+            nodes[segs[s].last].next = v;
+            nodes[v].prev = segs[s].last;
+        }
+        segs[s].last = v;
+    }
+    for (int s = 0; s < segments; ++s) {
+        segs[s].next = (s + 1) % segments;
+        segs[s].prev = (s + segments - 1) % segments;
+        segs[s].rank = s;
+    }
+}
+
+// make t follow s in the current orientation of the ring
+void TwoLevelList::linkSegments(int s, int t) {
+    if (reversed) {
+        segs[s].prev = t;
+        segs[t].next = s;
+    } else {
+        segs[s].next = t;
+        segs[t].prev = s;
+    }
+}
+
+// append v after the tail of segment s
+void TwoLevelList::pushTail(int s, int v) {
+    nodes[v].parent = s;
+    segs[s].count++;
+    if (flipped(s)) {
+        int f = segs[s].first;
+        nodes[v].seq = nodes[f].seq - 1;
+        nodes[v].prev = -1;
+        nodes[v].next = f;
+        nodes[f].prev = v;
+        segs[s].first = v;
+    } else {
+        int l = segs[s].last;
+        nodes[v].seq = nodes[l].seq + 1;
+        nodes[v].next = -1;
+        nodes[v].prev = l;
+        nodes[l].next = v;
+        segs[s].last = v;
+    }
+    if (std::abs(nodes[v].seq) > SEQ_LIMIT) renumber(s);
+}
+
+// insert v before the head of segment s
+void TwoLevelList::pushHead(int s, int v) {
+    nodes[v].parent = s;
+    segs[s].count++;
+    if (flipped(s)) {
+        int l = segs[s].last;
+        nodes[v].seq = nodes[l].seq + 1;
+        nodes[v].next = -1;
+        nodes[v].prev = l;
+        nodes[l].next = v;
+        segs[s].last = v;
+    } else {
+        int f = segs[s].first;
+        nodes[v].seq = nodes[f].seq - 1;
+        nodes[v].prev = -1;
+        nodes[v].next = f;
+        nodes[f].prev = v;
+        segs[s].first = v;
+    }
+    if (std::abs(nodes[v].seq) > SEQ_LIMIT) renumber(s);
+}
+
+void TwoLevelList::renumber(int s) {
+    int i = 0;
+    for (int v = segs[s].first; v >= 0; v = nodes[v].next) nodes[v].seq = i++;
+}
+
+// make v the head of its segment by moving the smaller of the two parts around it into the neighbor segment:
+// the nodes before v go after the tail of the previous segment, or v and the nodes after it before the head of
+// the next one. Nothing is ever pushed before the head of segment `keep`
+void TwoLevelList::split(int v, int keep) {
+    int s = nodes[v].parent;
+    if (v == head(s)) return;
+    int before = offset(v);
+    int p = segPrev(s), q = segNext(s);
+    bool move_before = 2 * before <= segs[s].count || q == keep;
+    touched.push_back(s);
+    touched.push_back(move_before ? p : q);
+
+    if (move_before) {
+        int u = head(s);
+        while (u != v) {
+            int w = flipped(s) ? nodes[u].prev : nodes[u].next;
+            pushTail(p, u);
+            u = w;
+        }
+        if (flipped(s)) {
+            segs[s].last = v;
+            nodes[v].next = -1;
+        } else {
+            segs[s].first = v;
+            nodes[v].prev = -1;
+        }
+        segs[s].count -= before;
+    } else {
+        int pv = flipped(s) ? nodes[v].next : nodes[v].prev;
+        int u = tail(s);
+        while (true) {
+            int w = flipped(s) ? nodes[u].next : nodes[u].prev;
+            pushHead(q, u);
+            if (u == v) break;
+            u = w;
+        }
+        if (flipped(s)) {
+            segs[s].first = pv;
+            nodes[pv].prev = -1;
+        } else {
+            segs[s].last = pv;
+            nodes[pv].next = -1;
+        }
+        segs[s].count = before;
+    }
+}
+
+// reverse a short path node by node: the path keeps the places (segment, sequence number) it occupies in tour order
+// and its nodes move into them backwards, so no segment changes size. Consecutive places are linked when they
+// were linked before, otherwise they are the tail and the head of two segments
+void TwoLevelList::reversePath(int a, int b) {
+    int before = prev(a), after = next(b);
+    buffer.clear();
+    for (int u = a;; u = next(u)) {
+        buffer.push_back(u);
+        if (u == b) break;
+    }
+    int m = (int)buffer.size();
+    places.clear();
+    for (int u : buffer) places.push_back({nodes[u].parent, nodes[u].seq});
+    // linked[i]: place i - 1 and place i are linked, place -1 being `before` and place m `after`
+    linked.assign(m + 1, 0);
+    for (int i = 0; i <= m; ++i) {
+        int x = i == 0 ? before : buffer[i - 1], y = i == m ? after : buffer[i];
+        linked[i] = nodes[x].parent == nodes[y].parent && x != tail(nodes[x].parent);
+    }
+
+    std::reverse(buffer.begin(), buffer.end());
+    for (int i = 0; i < m; ++i) {
+        nodes[buffer[i]].parent = places[i].first;
+        nodes[buffer[i]].seq = places[i].second;
+    }
+    for (int i = 0; i <= m; ++i) {
+        int x = i == 0 ? before : buffer[i - 1], y = i == m ? after : buffer[i];
+        int sx = nodes[x].parent, sy = nodes[y].parent;
+        if (linked[i]) {
+            if (flipped(sx)) {
+                nodes[x].prev = y;
+                nodes[y].next = x;
+            } else {
+                nodes[x].next = y;
+                nodes[y].prev = x;
+            }
+            continue;
+        }
+        if (flipped(sx)) {
+            segs[sx].first = x;
+            nodes[x].prev = -1;
+        } else {
+            segs[sx].last = x;
+            nodes[x].next = -1;
+        }
+        if (flipped(sy)) {
+            segs[sy].last = y;
+            nodes[y].next = -1;
+        } else {
+            segs[sy].first = y;
+            nodes[y].prev = -1;
+        }
+    }
+}
+
+// reverse the chain of whole segments s .. t: each one changes direction and they are linked back in the opposite
+// order, taking over the ranks of the positions they land on
+void TwoLevelList::reverseChain(int s, int t) {
+    int before = segPrev(s), after = segNext(t);
+    buffer.clear();
+    for (int x = s;; x = segNext(x)) {
+        buffer.push_back(x);
+        if (x == t) break;
+    }
+    int m = (int)buffer.size();
+    for (int i = 0; i < m / 2; ++i) std::swap(segs[buffer[i]].rank, segs[buffer[m - 1 - i]].rank);
+    for (int x : buffer) segs[x].rev = !segs[x].rev;
+
+    linkSegments(before, buffer[m - 1]);
+    for (int i = m - 1; i > 0; --i) linkSegments(buffer[i], buffer[i - 1]);
+    linkSegments(buffer[0], after);
+}
+
+void TwoLevelList::flip(int a, int b) {
+    touched.clear();
+    reverse(a, b);
+    // a segment cut in two or merged away is no longer the one of the list, only its current size counts
+    for (size_t i = 0; i < touched.size(); ++i) {
+        int s = touched[i];
+        if (segs[s].count > 2 * group) {
+            cutSegment(s);
+        } else if (segs[s].count > 0 && 2 * segs[s].count < group) {
+            mergeSegment(s);
+        }
+    }
+}
+
+void TwoLevelList::reverse(int a, int b) {
+    if (a == b) return;
+    // the whole cycle read the other way round
+    if (next(b) == a) {
+        reversed = !reversed;
+        return;
+    }
+    // short paths, or short complements, inside one segment or across the boundary of two are reversed node by node
+    int sa = nodes[a].parent, sb = nodes[b].parent;
+    if (sa == sb && offset(a) <= offset(b)) {
+        reversePath(a, b);
+        return;
+    }
+    if (sa == sb || (sa == segNext(sb) && segs[sb].count - offset(b) - 1 + offset(a) <= group)) {
+        // the path wraps around the whole tour
+        reversePath(next(b), prev(a));
+        reversed = !reversed;
+        return;
+    }
+    if (sb == segNext(sa) && segs[sa].count - offset(a) + offset(b) + 1 <= group) {
+        reversePath(a, b);
+        return;
+    }
+
+    // a becomes the head of its segment and b the tail of its own
+    split(a, -1);
+    if (nodes[a].parent == nodes[b].parent) {
+        // a was pushed before the head of the segment of b
+        reversePath(a, b);
+        return;
+    }
+    split(next(b), nodes[a].parent);
+
+    int s = nodes[a].parent, t = nodes[b].parent;
+    int chain = reversed ? segs[s].rank - segs[t].rank : segs[t].rank - segs[s].rank;
+    if (chain < 0) chain += segments;
+    chain++;
+    if (2 * chain <= segments) {
+        reverseChain(s, t);
+    } else {
+        reverseChain(segNext(t), segPrev(s));
+        reversed = !reversed;
+    }
+}
+
+// move the second half of s, in tour order, to a new segment right after it
+void TwoLevelList::cutSegment(int s) {
+    int t;
+    if (free_segs.empty()) {
+        t = (int)segs.size();
+        segs.push_back({-1, -1, 0, 0, 0, 0, false});
+    } else {
+        t = free_segs.back();
+        free_segs.pop_back();
+    }
+    // t keeps the links of the moved nodes and the direction of s: the second half is a suffix of the links of s,
+    // or a prefix if s is traversed backwards
+    int moved = segs[s].count - segs[s].count / 2;
+    int v = tail(s);
+    for (int i = 1; i < moved; ++i) v = flipped(s) ? nodes[v].next : nodes[v].prev;
+    segs[t].rev = segs[s].rev;
+    segs[t].count = moved;
+    segs[s].count -= moved;
+    if (flipped(s)) {
+        segs[t].first = segs[s].first;
+        segs[t].last = v;
+        segs[s].first = nodes[v].next;
+        nodes[segs[s].first].prev = -1;
+        nodes[v].next = -1;
+    } else {
+        segs[t].first = v;
+        segs[t].last = segs[s].last;
+        segs[s].last = nodes[v].prev;
+        nodes[segs[s].last].next = -1;
+        nodes[v].prev = -1;
+    }
+    for (int u = segs[t].first; u >= 0; u = nodes[u].next) nodes[u].parent = t;
+
+    int after = segNext(s);
+    linkSegments(s, t);
+    linkSegments(t, after);
+    segments++;
+    rankSegments();
+}
+
+// move the nodes of s into its smaller neighbor, unless that one would grow larger than twice the initial size
+void TwoLevelList::mergeSegment(int s) {
+    int p = segPrev(s), q = segNext(s);
+    if (p == s) return;
+    bool into_prev = segs[p].count <= segs[q].count;
+    if (segs[into_prev ? p : q].count + segs[s].count > 2 * group) return;
+
+    if (into_prev) {
+        for (int u = head(s); u >= 0;) {
+            int w = flipped(s) ? nodes[u].prev : nodes[u].next;
+            pushTail(p, u);
+            u = w;
+        }
+    } else {
+        for (int u = tail(s); u >= 0;) {
+            int w = flipped(s) ? nodes[u].next : nodes[u].prev;
+            pushHead(q, u);
+            u = w;
+        }
+    }
+    segs[s] = {-1, -1, 0, 0, 0, 0, false};
+    free_segs.push_back(s);
+    linkSegments(p, q);
+    segments--;
+    rankSegments();
+}
+
+// ranks increasing by one along the links of the ring, from the segment of node 0
+void TwoLevelList::rankSegments() {
+    int first = nodes[0].parent, r = 0;
+    int s = first;
+    do {
+        segs[s].rank = r++;
+        s = segs[s].next;
+    } while (s != first);
+}
+
+int TwoLevelList::largestSegment() const {
+    int largest = 0;
+    for (const Segment& s : segs) largest = std::max(largest, s.count);
+    return largest;
+}
+
+int TwoLevelList::node(int i) const {
+    if (i >= n) i -= n;
+    int s = nodes[0].parent;
+    int steps = offset(0) + i;
+    while (steps >= segs[s].count) {
+        steps -= segs[s].count;
+        s = segNext(s);
+    }
+    int v = head(s);
+    for (; steps > 0; --steps) v = flipped(s) ? nodes[v].prev : nodes[v].next;
+    return v;
+}
+
+int TwoLevelList::index(int v) const {
+    int s = nodes[0].parent, t = nodes[v].parent;
+    if (s == t && offset(v) >= offset(0)) return offset(v) - offset(0);
+    int steps = segs[s].count - offset(0);
+    for (int x = segNext(s); x != t; x = segNext(x)) steps += segs[x].count;
+    return steps + offset(v);
+}
@@ -0,0 +1,110 @@
+#ifndef TWOLEVELLIST_H
+#define TWOLEVELLIST_H
+
+#include <vector>
+#include <utility>
+
+// cyclic tour as a two-level doubly-linked list, the second layout of Tour (Tour.h)
+// the nodes are split into about sqrt(n) segments; each segment is a doubly-linked list of its nodes with a sequence
+// number per node and a reversal bit, and the segments form a ring with a rank per segment. next/prev/between are
+// O(1). A path shorter than a segment is reversed node by node; a longer one splits at most two segments at its ends,
+// moving the smaller part of each into the neighbor segment, then reverses the chain of whole segments in between
+// (or the complementary chain) by switching their reversal bits, so it costs O(sqrt(n)) instead of the O(n) of an array.
+// The segments a flip made larger than twice the initial size are cut in two, and those made smaller than half of it
+// are merged into a neighbor, so the sizes, and the number of segments, stay within a constant factor of sqrt(n)
+class TwoLevelList {
+public:
+    TwoLevelList() = default;
+    // the n nodes in tour order
+    explicit TwoLevelList(const std::vector<int>& order);
+
+    int size() const { return n; }
+
+    int next(int v) const {
+        int s = nodes[v].parent;
+        if (flipped(s)) return v == segs[s].first ? head(segNext(s)) : nodes[v].prev;
+        return v == segs[s].last ? head(segNext(s)) : nodes[v].next;
+    }
+    int prev(int v) const {
+        int s = nodes[v].parent;
+        if (flipped(s)) return v == segs[s].last ? tail(segPrev(s)) : nodes[v].next;
+        return v == segs[s].first ? tail(segPrev(s)) : nodes[v].prev;
+    }
+    // true if b is met going from a to c with next(), a and c included
+    bool between(int a, int b, int c) const {
+        long long ka = key(a), kb = key(b), kc = key(c);
+        if (ka <= kc) return ka <= kb && kb <= kc;
+        return kb >= ka || kb <= kc;
+    }
+
+    // reverse the path from a to b following next()
+    void flip(int a, int b);
+
+    // node i steps after node 0 and number of steps from node 0 to v, O(sqrt(n))
+    int node(int i) const;
+    int index(int v) const;
+
+    int segmentCount() const { return segments; }
+    // nodes in the largest segment, at most twice the initial size after any flip
+    int largestSegment() const;
+
+private:
+    int n = 0;
+    int segments = 0;
+    int group = 0;              // initial number of nodes per segment
+    bool reversed = false;      // the ring of segments is read backwards
+
+    // fields read together by next() share a cache line
+    struct Node {
+        int parent;
+        int seq;    // increasing from first to last of the segment
+        int next;   // links inside the segment, -1 at its ends
+        int prev;
+    };
+    struct Segment {
+        int first, last;    // end nodes in link order
+        int next, prev;     // links in the ring
+        int rank;           // position in the ring
+        int count;
+        bool rev;
+    };
+    std::vector<Node> nodes;
+    std::vector<Segment> segs;
+    std::vector<int> free_segs;     // entries of segs not in the ring, count 0
+    std::vector<int> touched;       // segments that changed size in the current flip
+
+    std::vector<int> buffer;
+    std::vector<std::pair<int, int>> places;
+    std::vector<char> linked;
+
+    // segment s is traversed from last to first
+    bool flipped(int s) const { return segs[s].rev != reversed; }
+    int head(int s) const { return flipped(s) ? segs[s].last : segs[s].first; }
+    int tail(int s) const { return flipped(s) ? segs[s].first : segs[s].last; }
+    int segNext(int s) const { return reversed ? segs[s].prev : segs[s].next; }
+    int segPrev(int s) const { return reversed ? segs[s].next : segs[s].prev; }
+    // steps from the head of its segment to v
+    int offset(int v) const {
+        int s = nodes[v].parent;
+        return flipped(s) ? nodes[segs[s].last].seq - nodes[v].seq : nodes[v].seq - nodes[segs[s].first].seq;
+    }
+    // increasing along the tour from the head of the segment of rank 0
+    long long key(int v) const {
+        int r = reversed ? segments - 1 - segs[nodes[v].parent].rank : segs[nodes[v].parent].rank;
+        return (long long)r * n + offset(v);
+    }
+
+    void linkSegments(int s, int t);
+    void pushTail(int s, int v);
+    void pushHead(int s, int v);
+    void renumber(int s);
+    void split(int v, int keep);
+    void reversePath(int a, int b);
+    void reverseChain(int s, int t);
+    void reverse(int a, int b);
+    void cutSegment(int s);
+    void mergeSegment(int s);
+    void rankSegments();
+};
+
+#endif
@@ -0,0 +1,84 @@
+#include "WorkStealingPool.h"
+#include <algorithm>
+
+// pool of the worker running on this thread
+static thread_local const WorkStealingPool* current_pool = nullptr;
+
+int WorkStealingPool::currentPoolSize() {
+    return current_pool ? current_pool->size() : 0;
+}
+
+WorkStealingPool::WorkStealingPool(int threads) {
+    threads = std::max(1, threads);
+    for (int w = 0; w < threads; ++w) queues.push_back(std::make_unique<Queue>());
+    for (int w = 0; w < threads; ++w) workers.emplace_back(&WorkStealingPool::run, this, w);
+}
+
+WorkStealingPool::~WorkStealingPool() {
+    wait();
+    {
+        std::lock_guard<std::mutex> lock(m);
+        stopping = true;
+    }
+    work_cv.notify_all();
+    for (auto& t : workers) t.join();
+}
+
+void WorkStealingPool::submit(std::function<void()> task) {
+    Queue& q = *queues[next_queue++ % queues.size()];
+    {
+        std::lock_guard<std::mutex> lock(q.m);
+        q.tasks.push_back(std::move(task));
+    }
+    {
+        std::lock_guard<std::mutex> lock(m);
+        queued++;
+        unfinished++;
+    }
+    work_cv.notify_one();
+}
+
+void WorkStealingPool::wait() {
+    std::unique_lock<std::mutex> lock(m);
+    idle_cv.wait(lock, [&] { return unfinished == 0; });
+}
+
+// own deque from the front, then the back of the other deques starting from the next worker
+bool WorkStealingPool::take(int w, std::function<void()>& task) {
+    int count = (int)queues.size();
+    for (int i = 0; i < count; ++i) {
+        Queue& q = *queues[(w + i) % count];
+        std::lock_guard<std::mutex> lock(q.m);
+        if (q.tasks.empty()) continue;
+        if (i == 0) {
+            task = std::move(q.tasks.front());
+            q.tasks.pop_front();
+        } else {
+            task = std::move(q.tasks.back());
+            q.tasks.pop_back();
+        }
+        return true;
+    }
+    return false;
+}
+
+void WorkStealingPool::run(int w) {
+    current_pool = this;
+    std::function<void()> task;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(m);
+            work_cv.wait(lock, [&] { return stopping || queued > 0; });
+            if (queued == 0) return;
+            // claim one of the queued tasks before looking for it, so that the workers woken up never outnumber them
+            queued--;
+        }
+        // a claimed task is in some deque until taken, each worker only takes what it has claimed
+        while (!take(w, task)) std::this_thread::yield();
+        task();
+        task = nullptr;
+
+        std::lock_guard<std::mutex> lock(m);
+        if (--unfinished == 0) idle_cv.notify_all();
+    }
+}
@@ -0,0 +1,55 @@
+#ifndef WORKSTEALINGPOOL_H
+#define WORKSTEALINGPOOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// fixed set of worker threads, each with its own task deque
+// submitted tasks are dealt to the deques in turn; a worker runs its own tasks in submission order and, when its
+// deque is empty, steals the most recently submitted task of another worker, so a worker stuck on a long task
+// never holds back the short ones queued behind it
+// tasks must not throw
+class WorkStealingPool {
+public:
+    explicit WorkStealingPool(int threads);
+    // waits for the tasks still queued before stopping the workers
+    ~WorkStealingPool();
+
+    WorkStealingPool(const WorkStealingPool&) = delete;
+    WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+    void submit(std::function<void()> task);
+    // block until every task submitted so far has run
+    void wait();
+    int size() const { return (int)workers.size(); }
+    // size of the pool the calling thread is a worker of, 0 outside of the workers
+    static int currentPoolSize();
+
+private:
+    struct Queue {
+        std::mutex m;
+        std::deque<std::function<void()>> tasks;
+    };
+    std::vector<std::unique_ptr<Queue>> queues;
+    std::vector<std::thread> workers;
+
+    // queued counts the tasks waiting in the deques, unfinished also the running ones
+    std::mutex m;
+    std::condition_variable work_cv;
+    std::condition_variable idle_cv;
+    int queued = 0;
+    int unfinished = 0;
+    bool stopping = false;
+    std::atomic<unsigned> next_queue{0};
+
+    bool take(int w, std::function<void()>& task);
+    void run(int w);
+};
+
+#endif
@@ -0,0 +1,193 @@
+// micro-benchmark suite, written as JSON so that two runs can be compared with bench/compare.py
+//   dist_*:        TSPInstance::dist() along a random tour and on random pairs, for the three distance modes
+//   two_opt_*:     TSPHeuristic::twoOptDelta() for random cuts of a Tour
+//   three_opt_*:   TSPHeuristic::threeOptDelta() on the 7 reconnections of random triples of cuts, as the 3-opt
+//                  search scores them
+//   reverse_*:     Tour::reverse() of random segments, array layout, and flip() of the two-level list
+//   greedy_*:      greedyTour() on random instances of 100, 1k, 10k and 100k nodes
+// every instance and every sequence of operations comes from fixed seeds, each timing is the best of 5 runs
+// usage: ./bench_suite [output.json] (default bench.json)
+
+#include "../TSPInstance.h"
+#include "../TSPConstruction.h"
+#include "../Tour.h"
+#include "../TSPHeuristic.h"
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <random>
+#include <chrono>
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <string>
+
+using Clock = std::chrono::steady_clock;
+
+struct Result {
+    std::string name;
+    int n;
+    double ops;         // operations per run
+    double ns_per_op;
+};
+
+// best of 5 runs of f(), which performs `ops` operations and returns a value that keeps the work alive
+template <class F>
+Result measure(const std::string& name, int n, double ops, F f, double& sink) {
+    double best = 1e300;
+    for (int run = 0; run < 5; ++run) {
+        auto start = Clock::now();
+        sink += f();
+        best = std::min(best, std::chrono::duration<double, std::nano>(Clock::now() - start).count());
+    }
+    std::cout << name << " (n = " << n << "): " << best / ops << " ns/op" << std::endl;
+    return {name, n, ops, best / ops};
+}
+
+// uniform points on a square board with the density of the generated panels
+static TSPInstance randomInstance(int n, TSPInstance::DistanceMode mode, unsigned seed) {
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<double> coord(0.0, 10.0 * std::sqrt((double)n));
+    std::vector<double> x(n), y(n);
+    for (int i = 0; i < n; ++i) {
+        x[i] = coord(rng);
+        y[i] = coord(rng);
+    }
+    TSPInstance inst;
+    inst.setCoordinates(std::move(x), std::move(y));
+    inst.setDistanceMode(mode);
+    return inst;
+}
+
+static std::vector<int> randomTour(int n, std::mt19937& rng) {
+    std::vector<int> tour(n);
+    std::iota(tour.begin(), tour.end(), 0);
+    std::shuffle(tour.begin() + 1, tour.end(), rng);
+    tour.push_back(0);
+    return tour;
+}
+
+int main(int argc, char* argv[]) {
+    std::string output = argc >= 2 ? argv[1] : "bench.json";
+    std::vector<Result> results;
+    double sink = 0.0;
+
+    // distance lookups
+    const int lookup_n = 2000;
+    const std::pair<const char*, TSPInstance::DistanceMode> modes[] = {
+        {"matrix", TSPInstance::DistanceMode::Matrix},
+        {"packed", TSPInstance::DistanceMode::PackedMatrix},
+        {"lazy", TSPInstance::DistanceMode::Lazy},
+    };
+    for (const auto& [mode_name, mode] : modes) {
+        TSPInstance inst = randomInstance(lookup_n, mode, 1);
+        std::mt19937 rng(2);
+        std::vector<int> tour = randomTour(lookup_n, rng);
+        const int pairs = 1 << 20;
+        std::vector<int> ps(2 * pairs);
+        std::uniform_int_distribution<int> pick(0, lookup_n - 1);
+        for (int& p : ps) p = pick(rng);
+        const int passes = 512;
+
+        results.push_back(measure(std::string("dist_tour_") + mode_name, lookup_n, (double)passes * lookup_n, [&]() {
+            double sum = 0.0;
+            for (int p = 0; p < passes; ++p)
+                for (int i = 0; i < lookup_n; ++i) sum += inst.dist(tour[i], tour[i + 1]);
+            return sum;
+        }, sink));
+        results.push_back(measure(std::string("dist_random_") + mode_name, lookup_n, pairs, [&]() {
+            double sum = 0.0;
+            for (int i = 0; i < pairs; ++i) sum += inst.dist(ps[2 * i], ps[2 * i + 1]);
+            return sum;
+        }, sink));
+    }
+
+    // move evaluation, on the matrix of a small instance and on the lazy distances of a large one
+    for (int n : {2000, 100000}) {
+        TSPInstance inst = randomInstance(n, TSPInstance::DistanceMode::Auto, 3);
+        std::mt19937 rng(4);
+        Tour tour(randomTour(n, rng));
+        const int moves = 1 << 20;
+        std::vector<int> cuts(3 * moves);
+        std::uniform_int_distribution<int> pick(1, n - 1);
+        for (int m = 0; m < moves; ++m) {
+            int c[3] = {pick(rng), pick(rng), pick(rng)};
+            std::sort(c, c + 3);
+            std::copy(c, c + 3, cuts.begin() + 3 * m);
+        }
+
+        results.push_back(measure("two_opt_delta", n, moves, [&]() {
+            double sum = 0.0;
+            for (int m = 0; m < moves; ++m) sum += TSPHeuristic::twoOptDelta(inst, tour, cuts[3 * m], cuts[3 * m + 2]);
+            return sum;
+        }, sink));
+        results.push_back(measure("three_opt_delta", n, moves, [&]() {
+            double sum = 0.0;
+            for (int m = 0; m < moves; ++m) {
+                int i = cuts[3 * m], j = cuts[3 * m + 1], k = cuts[3 * m + 2];
+                double best = 0.0;
+                for (int move = 1; move <= 7; ++move) {
+                    best = std::min(best, TSPHeuristic::threeOptDelta(inst, tour, i, j, k, move));
+                }
+                sum += best;
+            }
+            return sum;
+        }, sink));
+    }
+
+    // segment reversal; the same tour is reversed again at every run, which is still a random tour
+    for (int n : {1000, 10000, 100000}) {
+        std::mt19937 rng(5);
+        Tour tour(randomTour(n, rng));
+        const int flips = n >= 100000 ? 2000 : 100000;
+        std::vector<int> segs(2 * flips);
+        std::uniform_int_distribution<int> pick(1, n - 1);
+        for (int f = 0; f < flips; ++f) {
+            int i = pick(rng), j = pick(rng);
+            segs[2 * f] = std::min(i, j);
+            segs[2 * f + 1] = std::max(i, j);
+        }
+        results.push_back(measure("reverse_array", n, flips, [&]() {
+            for (int f = 0; f < flips; ++f) tour.reverse(segs[2 * f], segs[2 * f + 1]);
+            return (double)tour.node(1);
+        }, sink));
+    }
+    {
+        const int n = 100000, flips = 100000;
+        std::mt19937 rng(6);
+        Tour tour(randomTour(n, rng), Tour::Layout::TwoLevel);
+        std::vector<int> ends(2 * flips);
+        std::uniform_int_distribution<int> pick(0, n - 1);
+        for (int& v : ends) v = pick(rng);
+        results.push_back(measure("flip_two_level", n, flips, [&]() {
+            for (int f = 0; f < flips; ++f) tour.flip(ends[2 * f], ends[2 * f + 1]);
+            return (double)tour.next(0);
+        }, sink));
+    }
+
+    // greedy construction, all the edges up to GREEDY_ALL_EDGES_MAX_NODES and the matching above
+    for (int n : {100, 1000, 10000, 100000}) {
+        TSPInstance inst = randomInstance(n, TSPInstance::DistanceMode::Auto, 7);
+        results.push_back(measure("greedy_construction", n, 1, [&]() {
+            return (double)greedyTour(inst)[1];
+        }, sink));
+    }
+
+    std::ofstream out(output);
+    if (!out.is_open()) {
+        std::cerr << "Cannot open output file: " << output << std::endl;
+        return 1;
+    }
+    out << "{\n  \"benchmarks\": [\n";
+    for (size_t r = 0; r < results.size(); ++r) {
+        const Result& res = results[r];
+        out << "    {\"name\": \"" << res.name << "\", \"n\": " << res.n << ", \"ops\": " << (long long)res.ops
+            << ", \"ns_per_op\": " << res.ns_per_op << ", \"ops_per_s\": " << 1e9 / res.ns_per_op << "}"
+            << (r + 1 < results.size() ? "," : "") << "\n";
+    }
+    out << "  ]\n}\n";
+    std::cout << "results written to " << output << std::endl;
+    // keeps the compiler from dropping the loops
+    if (sink == 42.0) std::cout << "";
+    return 0;
+}
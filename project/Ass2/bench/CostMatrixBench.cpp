@@ -0,0 +1,127 @@
+// random-access lookup throughput of the cost matrix layouts
+// compares the former std::vector<std::vector<double>> matrix with the flat CostMatrix (full and packed storage)
+// on the two access patterns of the heuristics:
+//   tourLength: cost[t[i]][t[i+1]] along a random tour
+//   2-opt:      the 4 lookups of twoOptDelta() for random (i, j) cuts
+// usage: ./bench_matrix [n] (default 2000)
+
+#include "../CostMatrix.h"
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <random>
+#include <chrono>
+#include <algorithm>
+#include <numeric>
+#include <cmath>
+#include <string>
+
+using Clock = std::chrono::steady_clock;
+
+// nanoseconds per lookup of `lookups` lookups performed by f(), best of 5 runs
+template <class F>
+double nsPerLookup(F f, double lookups, double& sink) {
+    double best = 1e300;
+    for (int run = 0; run < 5; ++run) {
+        auto start = Clock::now();
+        sink += f();
+        double ns = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+        best = std::min(best, ns / lookups);
+    }
+    return best;
+}
+
+int main(int argc, char* argv[]) {
+    int n = argc >= 2 ? std::stoi(argv[1]) : 2000;
+
+    std::mt19937 rng(12345);
+    std::uniform_real_distribution<double> coord(0.0, 1000.0);
+    std::vector<double> xs(n), ys(n);
+    for (int i = 0; i < n; ++i) {
+        xs[i] = coord(rng);
+        ys[i] = coord(rng);
+    }
+    auto euclid = [&](int i, int j) { return std::hypot(xs[i] - xs[j], ys[i] - ys[j]); };
+
+    std::vector<std::vector<double>> nested(n, std::vector<double>(n, 0.0));
+    CostMatrix full(n, CostMatrix::Storage::Full);
+    CostMatrix packed(n, CostMatrix::Storage::Packed);
+    for (int i = 0; i < n; ++i) {
+        for (int j = i + 1; j < n; ++j) {
+            double d = euclid(i, j);
+            nested[i][j] = nested[j][i] = d;
+            full.set(i, j, d);
+            packed.set(i, j, d);
+        }
+    }
+
+    // random closed tour and random 2-opt cuts
+    std::vector<int> tour(n);
+    std::iota(tour.begin(), tour.end(), 0);
+    std::shuffle(tour.begin(), tour.end(), rng);
+    tour.push_back(tour[0]);
+    const int moves = 1 << 20;
+    std::vector<std::pair<int, int>> cuts(moves);
+    std::uniform_int_distribution<int> pick(1, n - 2);
+    for (auto& c : cuts) {
+        int i = pick(rng), j = pick(rng);
+        c = {std::min(i, j), std::max(i, j)};
+    }
+
+    const int passes = std::max(1, (1 << 22) / n);
+    double sink = 0.0;
+
+    auto tourLength = [&](auto cost) {
+        return [&, cost]() {
+            double sum = 0.0;
+            for (int p = 0; p < passes; ++p)
+                for (int i = 0; i < n; ++i) sum += cost(tour[i], tour[i + 1]);
+            return sum;
+        };
+    };
+    auto twoOpt = [&](auto cost) {
+        return [&, cost]() {
+            double sum = 0.0;
+            for (const auto& c : cuts) {
+                int a = tour[c.first - 1], b = tour[c.first];
+                int d = tour[c.second], e = tour[c.second + 1];
+                sum += cost(a, d) + cost(b, e) - cost(a, b) - cost(d, e);
+            }
+            return sum;
+        };
+    };
+
+    auto nestedCost = [&nested](int i, int j) { return nested[i][j]; };
+    auto fullCost = [&full](int i, int j) { return full(i, j); };
+    auto packedCost = [&packed](int i, int j) { return packed(i, j); };
+
+    double tour_lookups = (double)passes * n;
+    double move_lookups = 4.0 * moves;
+
+    struct Row {
+        std::string name;
+        double bytes, tour_ns, move_ns;
+    };
+    std::vector<Row> rows = {
+        {"vector<vector<double>>", (double)n * n * sizeof(double),
+         nsPerLookup(tourLength(nestedCost), tour_lookups, sink), nsPerLookup(twoOpt(nestedCost), move_lookups, sink)},
+        {"CostMatrix full", (double)full.bytes(),
+         nsPerLookup(tourLength(fullCost), tour_lookups, sink), nsPerLookup(twoOpt(fullCost), move_lookups, sink)},
+        {"CostMatrix packed", (double)packed.bytes(),
+         nsPerLookup(tourLength(packedCost), tour_lookups, sink), nsPerLookup(twoOpt(packedCost), move_lookups, sink)},
+    };
+
+    std::cout << "n = " << n << "\n";
+    std::cout << std::left << std::setw(26) << "layout" << std::right << std::setw(12) << "MB"
+              << std::setw(18) << "tourLength ns" << std::setw(14) << "2-opt ns"
+              << std::setw(16) << "speedup tour" << std::setw(16) << "speedup 2-opt" << "\n";
+    for (const auto& r : rows) {
+        std::cout << std::left << std::setw(26) << r.name << std::right << std::fixed << std::setprecision(1)
+                  << std::setw(12) << r.bytes / (1 << 20)
+                  << std::setprecision(2) << std::setw(18) << r.tour_ns << std::setw(14) << r.move_ns
+                  << std::setw(16) << rows[0].tour_ns / r.tour_ns << std::setw(16) << rows[0].move_ns / r.move_ns << "\n";
+    }
+    // keeps the compiler from dropping the loops
+    if (sink == 42.0) std::cout << "";
+    return 0;
+}
@@ -0,0 +1,109 @@
+// flip throughput of the two Tour layouts (Tour.h): array with shorter-side reversal and two-level doubly-linked list
+// on the two kinds of flips of the local searches, on a random tour:
+//   random: flip(a, b) for random nodes a and b, the reversed side has n/4 nodes on average
+//   local:  flip(a, b) with b at most 50 steps after a, as in the moves of LK on an already good tour
+// and the next() walk of tourLength. The flips are drawn beforehand on a separate array tour, so that only the flips
+// themselves are timed; both layouts replay the same sequence and their final tours are compared, and the segments
+// of the two-level list must still hold at most twice their initial size.
+// usage: ./bench_tour [n ...] (default 10000 100000 1000000)
+
+#include "../Tour.h"
+#include "../TwoLevelList.h"
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <random>
+#include <chrono>
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <string>
+
+using Clock = std::chrono::steady_clock;
+
+// nanoseconds per flip of the given flips applied to tour
+double nsPerFlip(Tour& tour, const std::vector<std::pair<int, int>>& flips) {
+    auto start = Clock::now();
+    for (const auto& f : flips) tour.flip(f.first, f.second);
+    return std::chrono::duration<double, std::nano>(Clock::now() - start).count() / flips.size();
+}
+
+double nsPerNext(const Tour& tour, int passes, long long& sink) {
+    int n = tour.size();
+    auto start = Clock::now();
+    for (int p = 0; p < passes; ++p) {
+        int v = 0;
+        for (int i = 0; i < n; ++i) v = tour.next(v);
+        sink += v;
+    }
+    return std::chrono::duration<double, std::nano>(Clock::now() - start).count() / ((double)passes * n);
+}
+
+int main(int argc, char* argv[]) {
+    std::vector<int> sizes;
+    for (int a = 1; a < argc; ++a) sizes.push_back(std::stoi(argv[a]));
+    if (sizes.empty()) sizes = {10000, 100000, 1000000};
+
+    std::cout << std::left << std::setw(10) << "n" << std::setw(12) << "layout" << std::right
+              << std::setw(16) << "random ns" << std::setw(14) << "local ns" << std::setw(12) << "next ns"
+              << std::setw(18) << "speedup random" << std::setw(16) << "speedup local" << "\n";
+
+    long long sink = 0;
+    for (int n : sizes) {
+        std::mt19937 rng(12345);
+        std::vector<int> order(n);
+        std::iota(order.begin(), order.end(), 0);
+        std::shuffle(order.begin(), order.end(), rng);
+
+        // the array spends O(n) per random flip, fewer of them keep the run short
+        int random_flips = (int)std::min(200000LL, std::max(1000LL, 20000000000LL / ((long long)n * n / 4 + 1)));
+        int local_flips = 1000000;
+        std::uniform_int_distribution<int> pick(0, n - 1), near(1, 50);
+        std::vector<std::pair<int, int>> random, local;
+        for (int i = 0; i < random_flips; ++i) random.push_back({pick(rng), pick(rng)});
+        // local flips depend on the tour they are applied to: they are drawn while replaying everything on a copy
+        Tour draft(order);
+        for (const auto& f : random) draft.flip(f.first, f.second);
+        for (int i = 0; i < local_flips; ++i) {
+            int a = pick(rng), b = a;
+            for (int s = near(rng); s > 0; --s) b = draft.next(b);
+            draft.flip(a, b);
+            local.push_back({a, b});
+        }
+
+        double ns[2][3];
+        std::vector<int> tours[2];
+        Tour::Layout layouts[2] = {Tour::Layout::Array, Tour::Layout::TwoLevel};
+        for (int l = 0; l < 2; ++l) {
+            Tour tour(order, layouts[l]);
+            ns[l][0] = nsPerFlip(tour, random);
+            ns[l][1] = nsPerFlip(tour, local);
+            ns[l][2] = nsPerNext(tour, std::max(1, 20000000 / n), sink);
+            tours[l] = tour.closedOrder();
+        }
+
+        const char* names[2] = {"array", "two-level"};
+        for (int l = 0; l < 2; ++l) {
+            std::cout << std::left << std::setw(10) << n << std::setw(12) << names[l] << std::right << std::fixed
+                      << std::setprecision(1) << std::setw(16) << ns[l][0] << std::setw(14) << ns[l][1]
+                      << std::setw(12) << ns[l][2] << std::setprecision(2) << std::setw(18) << ns[0][0] / ns[l][0]
+                      << std::setw(16) << ns[0][1] / ns[l][1] << "\n";
+        }
+        if (tours[0] != tours[1]) {
+            std::cout << "the two layouts disagree on n = " << n << "\n";
+            return 1;
+        }
+        TwoLevelList list(order);
+        for (const auto& f : random) list.flip(f.first, f.second);
+        for (const auto& f : local) list.flip(f.first, f.second);
+        int group = n / std::max(1, (int)std::sqrt((double)n));
+        if (list.largestSegment() > 2 * group) {
+            std::cout << "a segment of the two-level list grew to " << list.largestSegment() << " nodes on n = " << n
+                      << ", more than twice " << group << "\n";
+            return 1;
+        }
+    }
+    // keeps the compiler from dropping the loops
+    if (sink == 42) std::cout << "";
+    return 0;
+}
@@ -0,0 +1,41 @@
+#!/usr/bin/env python3
+# compare two JSON files written by bench_suite (make bench)
+# usage: python3 bench/compare.py <before.json> <after.json> [threshold percent, default 5]
+# prints ns/op of both runs and the change of each benchmark; exits with 1 if one got slower by more than the threshold
+import json
+import sys
+
+
+def load(path):
+    with open(path) as f:
+        return {(b["name"], b["n"]): b for b in json.load(f)["benchmarks"]}
+
+
+def main():
+    if len(sys.argv) < 3:
+        print("usage: compare.py <before.json> <after.json> [threshold percent]")
+        return 2
+    before, after = load(sys.argv[1]), load(sys.argv[2])
+    threshold = float(sys.argv[3]) if len(sys.argv) > 3 else 5.0
+
+    print("%-22s %8s %14s %14s %9s" % ("benchmark", "n", "before ns/op", "after ns/op", "change"))
+    slower = 0
+    for key in sorted(set(before) | set(after), key=lambda k: (k[0], k[1])):
+        name, n = key
+        if key not in before or key not in after:
+            print("%-22s %8d %s" % (name, n, "only in " + (sys.argv[2] if key in after else sys.argv[1])))
+            continue
+        old, new = before[key]["ns_per_op"], after[key]["ns_per_op"]
+        change = (new - old) / old * 100.0
+        flag = ""
+        if change > threshold:
+            flag = "  slower"
+            slower += 1
+        elif change < -threshold:
+            flag = "  faster"
+        print("%-22s %8d %14.2f %14.2f %+8.1f%%%s" % (name, n, old, new, change, flag))
+    return 1 if slower else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
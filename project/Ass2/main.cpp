@@ -2,94 +2,725 @@
 #include <vector>
 #include <filesystem>
 #include <fstream>
+#include <sstream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <chrono>
+#include <algorithm>
+#include <ctime>
+#include <functional>
 
 #include "TSPInstance.h"
 #include "TSPHeuristic.h"
+#include "TSPLinKernighan.h"
+#include "TSPIteratedLocalSearch.h"
+#include "WorkStealingPool.h"
+#include "InstanceFile.h"
+#include "ResultStore.h"
+#include "TourCache.h"
+#include "TSPLowerBound.h"
 
 namespace fs = std::filesystem;
 
+// settings shared by all the instances of a run
+struct RunOptions {
+    std::string engine;
+    int k_neighbors;
+    bool quadrant;
+    std::string strategy;
+    TSPInstance::DistanceMode distance_mode;
+    Construction construction;
+    Tour::Layout layout;
+    // seconds per instance, 0 = until a local optimum (1 second for the iterated local search)
+    double time_limit;
+    // record the convergence trace of every instance
+    bool trace;
+    // start from the cached tour of an earlier revision of the instance (TourCache.h) and cache the final tours
+    bool warm_start;
+    // 1-trees of the Held-Karp lower bound computed after the solve, 0 = no bound, and seconds of it, 0 = no limit;
+    // the bound has this budget of its own, on top of the time limit of the solve
+    int bound_iterations;
+    double bound_time;
+    // iterated local search
+    int ils_threads;
+    long long ils_iterations;
+    unsigned long long seed;
+};
+
+// everything a run reports about one instance, filled by the thread solving it and written out by the main thread
+struct InstanceResult {
+    bool solved = false;
+    std::string report;     // text for std::cout
+    std::string errors;     // text for std::cerr
+    std::string csv_row;
+    std::string trace_rows;
+    SearchStats stats;
+    bool has_stats = false;     // only the 2-opt/3-opt engines count their moves, when built with TSP_STATS
+    double objValue = 0.0, solvingTime = 0.0, startValue = 0.0, constructionTime = 0.0;
+    double seconds = 0.0;   // CPU time spent reading and solving the instance
+};
+
+// CPU time of the calling thread: unlike the wall time of a task it does not grow while the thread waits for a core,
+// so the sum over the instances estimates the serial run even when there are more workers than cores
+static double threadCpuSeconds() {
+    timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// version of the solvers and of the csv columns in the result store: bump it with any change to a heuristic or to
+// the columns, so that the records of the earlier code are solved again instead of being served as they are
+static const int RESULT_VERSION = 3;
+
+// the options that change the result of an instance, the key of its record in the result store with the content
+// hash of the instance (the number of instances solved at once and the trace do not change it); the version and
+// whether the counters are compiled in belong to it too
+static std::string optionsKey(const RunOptions& opt) {
+    std::ostringstream key;
+    key << "v" << RESULT_VERSION << (STATS_ENABLED ? " stats " : " ") << opt.engine << " k=" << opt.k_neighbors << (opt.quadrant ? "q" : "") << " s=" << opt.strategy
+        << " d=" << (int)opt.distance_mode << " c=" << constructionName(opt.construction)
+        << " l=" << (int)opt.layout << " t=" << opt.time_limit << (opt.warm_start ? " p" : "")
+        << " b=" << opt.bound_iterations << " B=" << opt.bound_time;
+    if (opt.engine == "ils") key << " w=" << opt.ils_threads << " i=" << opt.ils_iterations << " r=" << opt.seed;
+    return key.str();
+}
+
+// report of an instance skipped because the store already holds its result, in the layout of solveInstance()
+static InstanceResult storedResult(const std::string& fname, const ResultStore::Record& record, const RunOptions& opt) {
+    InstanceResult result;
+    // the tour closes the csv row, its nodes joined by '-'
+    std::string tour = record.columns.substr(record.columns.rfind(',') + 1);
+    std::replace(tour.begin(), tour.end(), '-', ' ');
+    std::ostringstream out;
+    out << "  Stored result, not solved again\n";
+    out << "  Feasible solution found with objValue " << record.obj_value << " with solving time (sec) "
+        << record.solving_time;
+    out << "\n  Starting tour (" << constructionName(opt.construction) << ") with objValue " << record.start_value
+        << " built in (sec) " << record.construction_time;
+    out << "\n  Solution (Tour): " << tour << " \n";
+    // lower bound and gap, the 2 columns before the tour, empty without a proven bound
+    std::vector<std::string> columns;
+    std::istringstream ss(record.columns);
+    for (std::string column; std::getline(ss, column, ',');) columns.push_back(column);
+    if (columns.size() >= 3 && !columns[columns.size() - 3].empty()) {
+        out << "  Lower bound (Held-Karp) " << columns[columns.size() - 3] << ", gap " << columns[columns.size() - 2]
+            << "%\n";
+    }
+    result.report = out.str();
+    result.csv_row = fname + "," + record.columns + "\n";
+    result.solved = true;
+    result.objValue = record.obj_value;
+    result.solvingTime = record.solving_time;
+    result.startValue = record.start_value;
+    result.constructionTime = record.construction_time;
+    return result;
+}
+
+// number of nodes from the first line of the file (the header of a binary one), used to schedule the largest
+// instances first
+static int peekNodeCount(const std::string& filename) {
+    if (TSPInstance::isTSPLIBFile(filename)) return TSPInstance::peekTSPLIBDimension(filename);
+    if (TSPInstance::isBinaryFile(filename)) {
+        std::ifstream fin(filename, std::ios::binary);
+        BinaryHeader header;
+        fin.read(reinterpret_cast<char*>(&header), sizeof(header));
+        return fin ? header.n : 0;
+    }
+    std::ifstream fin(filename);
+    int n = 0;
+    fin >> n;
+    return fin ? n : 0;
+}
+
+// a .tspb older than the text instance next to it was converted before the instance was edited: it is skipped and
+// the text file is read instead, otherwise its old content hash would also bring back the stored result of the old
+// instance
+static bool isStaleBinary(const fs::path& binary) {
+    for (const char* extension : {".dat", ".tsp"}) {
+        fs::path source = fs::path(binary).replace_extension(extension);
+        if (fs::exists(source) && fs::last_write_time(source) > fs::last_write_time(binary)) return true;
+    }
+    return false;
+}
+
+// value of a numeric option, which must be a number as a whole ("-j x" or "-j 4x" are errors, not 0 or 4)
+template <typename T>
+static bool numericOption(const std::string& option, const std::string& value, T& result) {
+    std::istringstream ss(value);
+    T x;
+    if (!(ss >> x) || !(ss >> std::ws).eof()) {
+        std::cerr << "Invalid value for " << option << ": " << value << std::endl;
+        return false;
+    }
+    result = x;
+    return true;
+}
+
+static void solveInstance(TSPInstance& instance, const std::string& fname, const RunOptions& opt, TourCache* cache,
+                          InstanceResult& result) {
+    if (opt.k_neighbors > 0) {
+        instance.buildNeighborLists(opt.k_neighbors, opt.quadrant);
+    }
+
+    double objValue = 0.0;
+    double solvingTime = 0.0;
+    double startValue = 0.0;
+    double constructionTime = 0.0;
+    bool timeLimitReached = false;
+    long long ilsKicks = 0;
+    std::vector<int> tour;
+
+    // the clock starts once the candidate lists are built, as solving_time does
+    auto deadline = std::chrono::steady_clock::time_point::max();
+    if (opt.time_limit > 0) {
+        deadline = std::chrono::steady_clock::now() + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                                                           std::chrono::duration<double>(opt.time_limit));
+    }
+    // convergence trace: an improvement is recorded at most every millisecond, a local search makes millions of them
+    std::ostringstream trace;
+    double last_traced = -1.0;
+    auto onIncumbent = [&](double elapsed, double objective) {
+        if (elapsed - last_traced < 1e-3) return;
+        trace << fname << "," << elapsed << "," << objective << "\n";
+        last_traced = elapsed;
+    };
+    std::function<void(double, double)> callback;
+    if (opt.trace) callback = onIncumbent;
+
+    // starting tour adapted from the cached tour of an earlier revision, the time spent on it is construction time
+    TourCache::Start warm;
+    double warm_seconds = 0.0;
+    if (cache) {
+        auto warm_begin = std::chrono::steady_clock::now();
+        warm = cache->startTour(instance);
+        warm_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - warm_begin).count();
+    }
+
+    try {
+        if (opt.engine == "ils") {
+            TSPIteratedLocalSearch model(instance);
+            model.setConstruction(opt.construction);
+            model.setStartTour(warm.tour);
+            model.setTourLayout(opt.layout);
+            model.setIncumbentCallback(callback);
+            model.setTimeLimit(opt.time_limit > 0 ? opt.time_limit : 1.0);
+            model.setThreads(opt.ils_threads);
+            model.setMaxIterations(opt.ils_iterations);
+            model.setSeed(opt.seed);
+            model.solve();
+            objValue = model.getObjValue();
+            solvingTime = model.getSolvingTime();
+            startValue = model.getStartValue();
+            constructionTime = model.getConstructionTime();
+            timeLimitReached = model.getTimeLimitReached();
+            ilsKicks = model.getIterations();
+            tour = model.getTour();
+        } else if (opt.engine == "lk") {
+            TSPLinKernighan model(instance);
+            model.setConstruction(opt.construction);
+            model.setStartTour(warm.tour);
+            model.setTourLayout(opt.layout);
+            model.setIncumbentCallback(callback);
+            model.solve(deadline);
+            objValue = model.getObjValue();
+            solvingTime = model.getSolvingTime();
+            startValue = model.getStartValue();
+            constructionTime = model.getConstructionTime();
+            timeLimitReached = model.getTimeLimitReached();
+            tour = model.getTour();
+        } else {
+            TSPHeuristic model(instance);
+            if (opt.engine == "adv") model.setThreeOpt(TSPHeuristic::ThreeOptMoves::Full);
+            if (opt.engine == "oropt") model.setThreeOpt(TSPHeuristic::ThreeOptMoves::OrOpt);
+            model.setTwoOptStrategy(opt.strategy == "queue" ? TSPHeuristic::TwoOptStrategy::DontLookBits
+                                                            : TSPHeuristic::TwoOptStrategy::LongEdgeFirst);
+            model.setConstruction(opt.construction);
+            model.setStartTour(warm.tour);
+            model.setIncumbentCallback(callback);
+            model.solve(deadline);
+            objValue = model.getObjValue();
+            solvingTime = model.getSolvingTime();
+            startValue = model.getStartValue();
+            constructionTime = model.getConstructionTime();
+            timeLimitReached = model.getTimeLimitReached();
+            tour = model.getTour();
+            result.stats = model.getStats();
+            // without the counters the columns stay empty, zeros would read as a search that moved nothing
+            result.has_stats = STATS_ENABLED;
+        }
+    } catch (const std::exception& e) {
+        result.errors += "Error solving model: " + std::string(e.what()) + "\n";
+        return;
+    }
+    constructionTime += warm_seconds;
+    solvingTime += warm_seconds;
+    if (cache) {
+        try {
+            cache->store(instance, tour, objValue);
+        } catch (const std::exception& e) {
+            result.errors += "Error caching the tour: " + std::string(e.what()) + "\n";
+        }
+    }
+
+    // the last improvement may have been skipped by the trace, the final tour closes it
+    if (opt.trace) {
+        last_traced = -1.0;
+        onIncumbent(solvingTime, objValue);
+    }
+    // a local search ends at a local optimum, unless the time limit stops it; the iterated local search ends
+    // at its time limit or after its kicks, or at its first local optimum when the instance is too small to kick
+    std::string status = timeLimitReached ? "TIME_LIMIT" : (ilsKicks > 0 ? "ITERATION_LIMIT" : "LOCAL_OPTIMUM");
+
+    std::ostringstream out;
+    if (timeLimitReached) out << "  Time limit reached, best tour so far kept\n";
+    out << "  Feasible solution found with objValue ";
+    out << objValue;
+    out << " with solving time (sec) ";
+    out << solvingTime;
+    out << "\n  Starting tour (";
+    if (warm.tour.empty()) {
+        out << constructionName(opt.construction);
+    } else {
+        out << "cached, " << warm.kept << " nodes kept, " << warm.inserted << " inserted, " << warm.dropped << " dropped";
+    }
+    out << ") with objValue " << startValue << " built in (sec) " << constructionTime;
+    out << "\n  Solution (Tour): ";
+    for (int v : tour) out << v << " ";
+        out << "\n";
+
+    // how far the tour can be from the optimum, computed apart from the solve with its own budget, so that an anytime
+    // engine that used all of its time limit still gets a gap; above TSPLowerBound::EXACT_MAX_NODES the bound comes
+    // from the candidate graph, valid but weaker
+    bool has_bound = false;
+    double lowerBound = 0.0, gap = 0.0;
+    if (opt.bound_iterations > 0) {
+        try {
+            TSPLowerBound bound(instance);
+            bound.setUpperBound(objValue);
+            bound.setMaxIterations(opt.bound_iterations);
+            bound.setTimeLimit(opt.bound_time);
+            bound.solve();
+            if (bound.getProven()) {
+                lowerBound = bound.getBound();
+                gap = lowerBound > 0.0 ? 100.0 * (objValue - lowerBound) / lowerBound : 0.0;
+                has_bound = true;
+                out << "  Lower bound (Held-Karp" << (bound.getExact() ? "" : ", candidate graph") << ") " << lowerBound
+                    << ", gap " << gap << "% computed in (sec) " << bound.getSolvingTime()
+                    << (bound.getTimeLimitReached() ? ", stopped at the time limit" : "") << "\n";
+            }
+        } catch (const std::exception& e) {
+            result.errors += "Error computing the lower bound: " + std::string(e.what()) + "\n";
+        }
+    }
+    result.report += out.str();
+
+    std::ostringstream tour_ss;
+    std::string tour_str;
+    // Convert tour to string for our csv
+    for (size_t i = 0; i < tour.size(); ++i) {
+        tour_ss << tour[i];
+        if (i != tour.size() - 1) tour_ss << "-";
+    }
+    tour_str = tour_ss.str();
+
+    std::ostringstream row;
+    row << fname << ","
+        << instance.n << ","
+        << objValue << ","
+        << solvingTime << ","
+        << startValue << ","
+        << constructionTime << ","
+        << status << ",";
+    // search counters, left empty for the engines that do not keep them
+    const SearchStats& st = result.stats;
+    if (result.has_stats) {
+        row << st.two_opt_evaluated << "," << st.two_opt_accepted << "," << st.two_opt_passes << ","
+            << st.two_opt_gain << "," << st.two_opt_time << ","
+            << st.three_opt_evaluated << "," << st.three_opt_accepted << "," << st.three_opt_passes << ","
+            << st.three_opt_gain << "," << st.three_opt_time << ","
+            << st.reversals << "," << st.moved_nodes << ",";
+    } else {
+        row << std::string(12, ',');
+    }
+    if (has_bound) {
+        row << lowerBound << "," << gap << ",";
+    } else {
+        row << ",,";
+    }
+    row << tour_str << "\n";
+    result.csv_row = row.str();
+    result.trace_rows = trace.str();
+
+    result.solved = true;
+    result.objValue = objValue;
+    result.solvingTime = solvingTime;
+    result.startValue = startValue;
+    result.constructionTime = constructionTime;
+}
+
 int main(int argc, char* argv[]) {
     std::string instance_filter = "all";
-    if (argc >= 2){
-        instance_filter = argv[1];   // i.e. "10", "20", "30", "50", "70", "80", "100", "all"
+    std::string engine = "2opt";
+    int k_neighbors = 0;        // 0 = full 2-opt/3-opt neighborhoods
+    bool quadrant = false;
+    std::string strategy = "long";     // 2-opt strategy: "long" (long edges first) or "queue" (don't-look bits)
+    std::string distances = "auto";    // "matrix", "packed" (upper triangle), "lazy" (computed from the coordinates) or "auto"
+    std::string start = "greedy";      // starting tour: "greedy", "curve" (Hilbert curve), "nn" (nearest neighbor), "savings"
+    std::string layout = "auto";       // tour of lk and ils: "array", "list" (two-level doubly-linked list) or "auto"
+    int threads = 1;                   // instances solved at the same time, 0 = one per hardware thread
+    double time_limit = 0.0;           // seconds per instance, 0 = no limit (1 second for the iterated local search)
+    bool trace = false;                // write the convergence trace of every instance
+    bool fresh = false;                // solve again the instances already in the result store
+    bool warm_start = false;           // start from the tour cache
+    int bound_iterations = 50;         // subgradient steps of the Held-Karp lower bound, 0 = no bound and no gap
+    double bound_time = 1.0;           // seconds of the subgradient steps, 0 = no limit
+    int ils_threads = 1;               // worker threads of the iterated local search, 0 = one per hardware thread
+    long long ils_iterations = 0;      // kicks per worker of the iterated local search, 0 = until the time limit
+    unsigned long long seed = 1;
+
+    // positional arguments: [filter] [engine]
+    // options: -k <neighbors> -q (quadrant candidate lists) -s <long|queue> -d <matrix|packed|lazy|auto>
+    //          -c <greedy|curve|nn|savings> -j <threads> -l <array|list|auto> -t <seconds per instance>
+    //          -v (convergence trace) -f (solve again the instances of the result store)
+    //          -p (start from the cached tours of the earlier revisions of the instances)
+    //          -b <1-trees of the Held-Karp lower bound, 0 = none, 50 by default> -B <seconds of the bound, 1 by default>
+    //          iterated local search: -w <workers> -i <kicks per worker> -r <seed>
+    int positional = 0;
+    for (int a = 1; a < argc; ++a) {
+        std::string arg = argv[a];
+        if (arg == "-k" && a + 1 < argc) {
+            if (!numericOption(arg, argv[++a], k_neighbors)) return 1;
+        } else if (arg == "-q") {
+            quadrant = true;
+        } else if (arg == "-s" && a + 1 < argc) {
+            strategy = argv[++a];
+        } else if (arg == "-d" && a + 1 < argc) {
+            distances = argv[++a];
+        } else if (arg == "-c" && a + 1 < argc) {
+            start = argv[++a];
+        } else if (arg == "-l" && a + 1 < argc) {
+            layout = argv[++a];
+        } else if (arg == "-j" && a + 1 < argc) {
+            if (!numericOption(arg, argv[++a], threads)) return 1;
+        } else if (arg == "-t" && a + 1 < argc) {
+            if (!numericOption(arg, argv[++a], time_limit)) return 1;
+        } else if (arg == "-v") {
+            trace = true;
+        } else if (arg == "-f") {
+            fresh = true;
+        } else if (arg == "-p") {
+            warm_start = true;
+        } else if (arg == "-b" && a + 1 < argc) {
+            if (!numericOption(arg, argv[++a], bound_iterations)) return 1;
+        } else if (arg == "-B" && a + 1 < argc) {
+            if (!numericOption(arg, argv[++a], bound_time)) return 1;
+        } else if (arg == "-w" && a + 1 < argc) {
+            if (!numericOption(arg, argv[++a], ils_threads)) return 1;
+        } else if (arg == "-i" && a + 1 < argc) {
+            if (!numericOption(arg, argv[++a], ils_iterations)) return 1;
+        } else if (arg == "-r" && a + 1 < argc) {
+            if (!numericOption(arg, argv[++a], seed)) return 1;
+        } else if (positional == 0) {
+            instance_filter = arg;   // i.e. "10", "20", "30", "50", "70", "80", "100", "all"
+            positional++;
+        } else if (positional == 1) {
+            // "2opt" (TSPHeuristic.cpp), "adv" or "oropt" (2-opt followed by the 3-opt or Or-opt of TSPAdvHeuristic.cpp),
+            // "lk" (TSPLinKernighan.cpp), "ils" (TSPIteratedLocalSearch.cpp)
+            engine = arg;
+            positional++;
+        } else {
+            std::cerr << "Unexpected argument: " << arg << std::endl;
+            return 1;
+        }
     }
+    if (engine != "2opt" && engine != "adv" && engine != "oropt" && engine != "lk" && engine != "ils") {
+        std::cerr << "Unknown engine: " << engine << std::endl;
+        return 1;
+    }
+    // Lin-Kernighan only moves along candidate edges
+    if ((engine == "lk" || engine == "ils") && k_neighbors == 0) {
+        k_neighbors = 8;
+        quadrant = true;
+    }
+    if (strategy != "long" && strategy != "queue") {
+        std::cerr << "Unknown 2-opt strategy: " << strategy << std::endl;
+        return 1;
+    }
+    TSPInstance::DistanceMode distance_mode = TSPInstance::DistanceMode::Auto;
+    if (distances == "matrix") {
+        distance_mode = TSPInstance::DistanceMode::Matrix;
+    } else if (distances == "packed") {
+        distance_mode = TSPInstance::DistanceMode::PackedMatrix;
+    } else if (distances == "lazy") {
+        distance_mode = TSPInstance::DistanceMode::Lazy;
+    } else if (distances != "auto") {
+        std::cerr << "Unknown distance mode: " << distances << std::endl;
+        return 1;
+    }
+
+    Construction construction = Construction::Greedy;
+    if (start == "curve") {
+        construction = Construction::SpaceFillingCurve;
+    } else if (start == "nn") {
+        construction = Construction::NearestNeighbor;
+    } else if (start == "savings") {
+        construction = Construction::Savings;
+    } else if (start != "greedy") {
+        std::cerr << "Unknown construction: " << start << std::endl;
+        return 1;
+    }
+    Tour::Layout tour_layout = Tour::Layout::Auto;
+    if (layout == "array") {
+        tour_layout = Tour::Layout::Array;
+    } else if (layout == "list") {
+        tour_layout = Tour::Layout::TwoLevel;
+    } else if (layout != "auto") {
+        std::cerr << "Unknown tour layout: " << layout << std::endl;
+        return 1;
+    }
+    if (threads <= 0) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    RunOptions options{engine, k_neighbors, quadrant, strategy, distance_mode, construction, tour_layout,
+                       time_limit, trace, warm_start, bound_iterations, bound_time, ils_threads, ils_iterations, seed};
 
     // the folder where all test samples are located
     std::string data_folder = "./data";
     // the folder where all solution to tests will be located
     fs::create_directories("./data/solution");
 
+    // results of the earlier runs of any filter, the instances solved with the same options are not solved again
+    std::unique_ptr<ResultStore> store;
+    try {
+        store = std::make_unique<ResultStore>("./data/solution/store.csv");
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+    const std::string options_key = optionsKey(options);
+    int stored = 0;
+
+    // best tour of every instance solved with -p, whatever the other options
+    std::unique_ptr<TourCache> tour_cache;
+    if (warm_start) {
+        try {
+            tour_cache = std::make_unique<TourCache>("./data/solution/tour_cache");
+        } catch (const std::exception& e) {
+            std::cerr << e.what() << std::endl;
+            return 1;
+        }
+    }
+
     // setup for the solution/report
-    std::string csv_name = "./data/solution/results_" + instance_filter + ".csv";
+    // the default engine, construction and 2-opt strategy keep the original report name, the others get their own
+    std::string csv_name = "./data/solution/results_" + instance_filter + (engine == "2opt" ? "" : "_" + engine) +
+                           (start == "greedy" ? "" : "_" + start) + (strategy == "long" ? "" : "_" + strategy) + ".csv";
     std::ofstream csv(csv_name);
     if (!csv.is_open()) {
         std::cerr << "Cannot open CSV file: " << csv_name << std::endl;
         return 1;
     }
-    csv << "instance,n,obj_value,solving_time\n";
+    csv << "instance,n,obj_value,solving_time,start_value,construction_time,status,"
+           "two_opt_evaluated,two_opt_accepted,two_opt_passes,two_opt_gain,two_opt_time,"
+           "three_opt_evaluated,three_opt_accepted,three_opt_passes,three_opt_gain,three_opt_time,"
+           "reversals,moved_nodes,lower_bound,gap\n";
+
+    // elapsed seconds and objective value of every traced improvement, as the time ladder of Ass1 reports
+    // the best value at each time limit
+    std::ofstream trace_csv;
+    if (trace) {
+        std::string trace_name = "./data/solution/trace_" + csv_name.substr(csv_name.rfind("results_") + 8);
+        trace_csv.open(trace_name);
+        if (!trace_csv.is_open()) {
+            std::cerr << "Cannot open CSV file: " << trace_name << std::endl;
+            return 1;
+        }
+        trace_csv << "instance,elapsed,obj_value\n";
+    }
 
-    // when this program is run, all data of our instance_filter are tested one by one
+    // all data of our instance_filter, reported in the order of their file names
+    struct InstanceFile {
+        std::string filename, fname;
+        int n;
+    };
+    std::vector<InstanceFile> files;
     for (const auto& entry : fs::directory_iterator(data_folder)) {
 
         // we avoid to select possible files different from the one we want with .dat extension, and also the /generator folder
+        // an instance converted to .tspb (tools/ConvertInstance.cpp) is read from the binary file instead, unless the
+        // binary file is stale
+        // TSPLIB files (.tsp) are read as well, a filter equal to their name selects a single one
         if (!entry.is_regular_file()) continue;
-        if (entry.path().extension() != ".dat") continue;
+        bool stale_binary = false;
+        if (entry.path().extension() == ".dat" || entry.path().extension() == ".tsp") {
+            fs::path binary = fs::path(entry.path()).replace_extension(".tspb");
+            if (fs::exists(binary)) {
+                stale_binary = isStaleBinary(binary);
+                if (!stale_binary) continue;
+            }
+        } else if (entry.path().extension() != ".tspb" || isStaleBinary(entry.path())) {
+            continue;
+        }
 
         std::string filename = entry.path().string();
         std::string fname = entry.path().filename().string();
         if (instance_filter != "all") {
             std::string key = "instance_" + instance_filter + "_";
-            if (fname.find(key) == std::string::npos) continue;
+            if (fname.find(key) == std::string::npos && entry.path().stem() != instance_filter) continue;
         }
-        std::cout << "Processing instance: " << fname << std::endl;
-
-        TSPInstance instance;
-        try {
-            instance = TSPInstance::readFromFile(filename);
-        } catch (const std::exception& e) {
-            std::cerr << "Error reading instance: " << e.what() << std::endl;
-            continue;
+        if (stale_binary) {
+            std::cerr << "Reading " << fname << ": its .tspb file is older, convert it again" << std::endl;
         }
+        files.push_back({filename, fname, peekNodeCount(filename)});
+    }
+    std::sort(files.begin(), files.end(), [](const InstanceFile& a, const InstanceFile& b) { return a.fname < b.fname; });
 
-        TSPHeuristic model(instance);
+    // largest instances first, so that a big one does not start last and stall the end of the run
+    std::vector<int> schedule(files.size());
+    for (size_t i = 0; i < files.size(); ++i) schedule[i] = (int)i;
+    std::stable_sort(schedule.begin(), schedule.end(), [&](int a, int b) { return files[a].n > files[b].n; });
 
-        try {
-                model.solve();
+    // the instances are read by a loader thread, at most 2 per worker ahead of the solved ones, and each one is
+    // handed to the pool as soon as it is parsed; the main thread writes the results in file name order
+    std::vector<InstanceResult> results(files.size());
+    std::vector<char> done(files.size(), 0);
+    std::mutex m;
+    std::condition_variable cv;
+    int in_flight = 0;
+    const int max_in_flight = 2 * threads;
+
+    auto run_start = std::chrono::steady_clock::now();
+    WorkStealingPool pool(threads);
+
+    std::thread loader([&]() {
+        for (int idx : schedule) {
+            {
+                std::unique_lock<std::mutex> lock(m);
+                cv.wait(lock, [&] { return in_flight < max_in_flight; });
+                in_flight++;
+            }
+            double read_start = threadCpuSeconds();
+            auto instance = std::make_shared<TSPInstance>();
+            bool skip = false;
+            try {
+                // lazy distances until the store is checked, a skipped instance never builds its matrix
+                *instance = TSPInstance::readFromFile(files[idx].filename, TSPInstance::DistanceMode::Lazy);
+                std::lock_guard<std::mutex> lock(m);
+                const ResultStore::Record* record = fresh ? nullptr : store->find(instance->content_hash, options_key);
+                if (record) {
+                    results[idx] = storedResult(files[idx].fname, *record, options);
+                    skip = true;
+                }
             } catch (const std::exception& e) {
-                std::cerr << "Error solving model: " << e.what() << std::endl;
-                break;
+                std::lock_guard<std::mutex> lock(m);
+                results[idx].errors = "Error reading instance: " + std::string(e.what()) + "\n";
+                skip = true;
             }
+            if (skip) {
+                std::lock_guard<std::mutex> lock(m);
+                results[idx].seconds = threadCpuSeconds() - read_start;
+                stored += results[idx].solved ? 1 : 0;
+                done[idx] = 1;
+                in_flight--;
+                cv.notify_all();
+                continue;
+            }
+            double read_seconds = threadCpuSeconds() - read_start;
+
+            pool.submit([&, idx, instance, read_seconds]() {
+                InstanceResult result;
+                double solve_start = threadCpuSeconds();
+                // the matrix is built by the worker, on its share of the cores (MatrixBuilder.h)
+                bool built = true;
+                try {
+                    instance->setDistanceMode(options.distance_mode);
+                } catch (const std::exception& e) {
+                    result.errors += "Error building the distances: " + std::string(e.what()) + "\n";
+                    built = false;
+                }
+                if (built) solveInstance(*instance, files[idx].fname, options, tour_cache.get(), result);
+                result.seconds = read_seconds + threadCpuSeconds() - solve_start;
+                // the iterated local search runs its own threads until its wall-clock budget is over,
+                // a serial run would spend the same time on it
+                if (options.engine == "ils") result.seconds = std::max(result.seconds, read_seconds + result.solvingTime);
 
-        double objValue = model.getObjValue();
-        double solvingTime = model.getSolvingTime();
-        auto tour = model.getTour();
-
-        std::cout << "  Feasible solution found with objValue ";
-        std::cout << objValue;
-        std::cout << " with solving time (sec) ";
-        std::cout << solvingTime;
-        std::cout << "\n  Solution (Tour): ";
-        for (int v : tour) std::cout << v << " ";
-            std::cout << "\n";
-
-        std::ostringstream tour_ss;
-        std::string tour_str;
-        // Convert tour to string for our csv
-        for (size_t i = 0; i < tour.size(); ++i) {
-            tour_ss << tour[i];
-            if (i != tour.size() - 1) tour_ss << "-";
+                std::lock_guard<std::mutex> lock(m);
+                if (result.solved) {
+                    ResultStore::Record record;
+                    record.obj_value = result.objValue;
+                    record.solving_time = result.solvingTime;
+                    record.start_value = result.startValue;
+                    record.construction_time = result.constructionTime;
+                    // the row without the instance name and its line break
+                    const std::string& row = result.csv_row;
+                    record.columns = row.substr(row.find(',') + 1, row.size() - row.find(',') - 2);
+                    store->add(instance->content_hash, options_key, record);
+                }
+                results[idx] = std::move(result);
+                done[idx] = 1;
+                in_flight--;
+                cv.notify_all();
+            });
         }
-        tour_str = tour_ss.str();
+    });
+
+    // averages per instance family (instance_<n>_*), to compare the starting tours on each size
+    struct FamilyStats {
+        int count = 0;
+        double start_value = 0.0, construction_time = 0.0, obj_value = 0.0, solving_time = 0.0;
+    };
+    std::map<std::string, FamilyStats> families;
+    double serial_seconds = 0.0;
 
-        csv << fname << ","
-            << instance.n << ","
-            << model.getObjValue() << ","
-            << model.getSolvingTime() << ","
-            << tour_str << "\n";
+    for (size_t i = 0; i < files.size(); ++i) {
+        InstanceResult result;
+        {
+            std::unique_lock<std::mutex> lock(m);
+            cv.wait(lock, [&] { return done[i] != 0; });
+            result = std::move(results[i]);
+        }
+        const std::string& fname = files[i].fname;
+        // written once the instance is done, in file name order whatever the order they were solved in
+        std::cout << "Processed instance: " << fname << std::endl;
+        std::cerr << result.errors;
+        std::cout << result.report;
+        serial_seconds += result.seconds;
+        if (!result.solved) continue;
+
+        csv << result.csv_row;
         csv.flush();
+        if (trace) trace_csv << result.trace_rows;
 
+        FamilyStats& family = families[fname.substr(0, fname.rfind('_'))];
+        family.count++;
+        family.start_value += result.startValue;
+        family.construction_time += result.constructionTime;
+        family.obj_value += result.objValue;
+        family.solving_time += result.solvingTime;
     }
+    loader.join();
+    pool.wait();
+    double wall_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - run_start).count();
 
     csv.close();
+
+    std::cout << "Averages per family with the " << constructionName(construction) << " starting tour:\n";
+    for (const auto& [name, family] : families) {
+        std::cout << "  " << name << " (" << family.count << " instances): start " << family.start_value / family.count
+                  << " in (sec) " << family.construction_time / family.count
+                  << ", final " << family.obj_value / family.count
+                  << " in (sec) " << family.solving_time / family.count << "\n";
+    }
+    // the serial time is what the instances took one after the other: reading plus solving each of them
+    // (the threads of buildCostMatrix() are not counted, so on matrix instances the speedup is underestimated)
+    std::cout << "Wall-clock time (sec) " << wall_seconds << " on " << threads << " thread(s), serial time (sec) "
+              << serial_seconds << ", speedup " << (wall_seconds > 0.0 ? serial_seconds / wall_seconds : 1.0) << "\n";
+    if (stored > 0) {
+        std::cout << stored << " instance(s) already solved with the same options taken from the result store"
+                  << " (-f solves them again)\n";
+    }
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,38 @@
+#ifndef CHECK_H
+#define CHECK_H
+
+#include <iostream>
+
+// the few checks the tests need: a failed CHECK prints its file, line and condition and the test goes on,
+// checkResult() is what main returns (0 if every check passed)
+static int check_failures = 0;
+
+#define CHECK(cond)                                                                            \
+    do {                                                                                       \
+        if (!(cond)) {                                                                         \
+            std::cerr << __FILE__ << ":" << __LINE__ << ": check failed: " #cond << std::endl; \
+            check_failures++;                                                                  \
+        }                                                                                      \
+    } while (0)
+
+// the statement must throw std::runtime_error
+#define CHECK_THROWS(stmt)                                                                          \
+    do {                                                                                            \
+        bool thrown = false;                                                                        \
+        try {                                                                                       \
+            stmt;                                                                                   \
+        } catch (const std::runtime_error&) {                                                       \
+            thrown = true;                                                                          \
+        }                                                                                           \
+        if (!thrown) {                                                                              \
+            std::cerr << __FILE__ << ":" << __LINE__ << ": no exception from " #stmt << std::endl; \
+            check_failures++;                                                                       \
+        }                                                                                           \
+    } while (0)
+
+static int checkResult(const char* name) {
+    std::cout << name << ": " << (check_failures == 0 ? "ok" : "FAILED") << std::endl;
+    return check_failures == 0 ? 0 : 1;
+}
+
+#endif
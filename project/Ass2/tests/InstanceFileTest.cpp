@@ -0,0 +1,105 @@
+// binary instance files (InstanceFile.h): a .tspb written from a text instance reads back with the same coordinates,
+// content hash and candidate lists, and corrupt or truncated files are rejected with an error
+
+#include "../TSPInstance.h"
+#include "../InstanceFile.h"
+#include "Check.h"
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iterator>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <unistd.h>
+
+namespace fs = std::filesystem;
+
+static std::vector<char> readBytes(const std::string& filename) {
+    std::ifstream fin(filename, std::ios::binary);
+    return std::vector<char>(std::istreambuf_iterator<char>(fin), std::istreambuf_iterator<char>());
+}
+
+static void writeBytes(const std::string& filename, const std::vector<char>& bytes) {
+    std::ofstream fout(filename, std::ios::binary | std::ios::trunc);
+    fout.write(bytes.data(), bytes.size());
+}
+
+int main() {
+    fs::path dir = fs::temp_directory_path() / ("tsp_instance_file_test_" + std::to_string(getpid()));
+    fs::create_directories(dir);
+    std::string text = (dir / "instance_500_1.dat").string();
+    std::string binary = (dir / "instance_500_1.tspb").string();
+
+    // the text format of the generator
+    std::mt19937 rng(3);
+    std::uniform_real_distribution<double> coord(0.0, 250.0);
+    const int n = 500;
+    {
+        std::ofstream fout(text);
+        fout.precision(17);
+        fout << n << "\n";
+        for (int i = 0; i < n; ++i) fout << coord(rng) << " " << coord(rng) << "\n";
+    }
+
+    TSPInstance original = TSPInstance::readFromFile(text, TSPInstance::DistanceMode::Lazy);
+    original.buildNeighborLists(8, true);
+    original.writeBinary(binary);
+
+    // round trip
+    {
+        TSPInstance copy = TSPInstance::readFromFile(binary, TSPInstance::DistanceMode::Lazy);
+        CHECK(copy.n == n);
+        CHECK(copy.content_hash == original.content_hash);
+        CHECK(copy.metric == original.metric);
+        CHECK(std::memcmp(copy.xs, original.xs, n * sizeof(double)) == 0);
+        CHECK(std::memcmp(copy.ys, original.ys, n * sizeof(double)) == 0);
+        copy.buildNeighborLists(8, true);
+        CHECK(copy.k_neighbors == 8);
+        CHECK(std::memcmp(copy.neighborsOf(0), original.neighborsOf(0), (size_t)n * 8 * sizeof(int)) == 0);
+        CHECK(copy.dist(3, 7) == original.dist(3, 7));
+    }
+
+    // one corruption at a time of a valid file, each must be an error rather than a crash
+    const std::vector<char> good = readBytes(binary);
+    BinaryHeader header;
+    std::memcpy(&header, good.data(), sizeof(header));
+    auto corrupt = [&](const std::function<void(std::vector<char>&, BinaryHeader&)>& edit) {
+        std::vector<char> bytes = good;
+        BinaryHeader h = header;
+        edit(bytes, h);
+        std::memcpy(bytes.data(), &h, sizeof(h));
+        writeBytes(binary, bytes);
+        return binary;
+    };
+    CHECK_THROWS(TSPInstance::readFromFile(corrupt([](std::vector<char>&, BinaryHeader& h) { h.magic[0] = 'X'; })));
+    CHECK_THROWS(TSPInstance::readFromFile(corrupt([](std::vector<char>&, BinaryHeader& h) { h.n = 1; })));
+    CHECK_THROWS(TSPInstance::readFromFile(corrupt([](std::vector<char>&, BinaryHeader& h) { h.n = 1 << 30; })));
+    CHECK_THROWS(TSPInstance::readFromFile(corrupt([](std::vector<char>&, BinaryHeader& h) { h.k_neighbors = -1; })));
+    CHECK_THROWS(TSPInstance::readFromFile(corrupt([](std::vector<char>&, BinaryHeader& h) { h.k_neighbors = 1 << 20; })));
+    CHECK_THROWS(TSPInstance::readFromFile(corrupt([](std::vector<char>&, BinaryHeader& h) { h.quadrant = 7; })));
+    CHECK_THROWS(TSPInstance::readFromFile(corrupt([](std::vector<char>&, BinaryHeader& h) { h.metric = 42; })));
+    CHECK_THROWS(TSPInstance::readFromFile(corrupt([](std::vector<char>&, BinaryHeader& h) { h.metric = -1; })));
+    CHECK_THROWS(TSPInstance::readFromFile(corrupt([](std::vector<char>&, BinaryHeader& h) { h.xs_offset = ~0ULL - 63; })));
+    CHECK_THROWS(TSPInstance::readFromFile(corrupt([](std::vector<char>&, BinaryHeader& h) { h.ys_offset += 8; })));
+    CHECK_THROWS(TSPInstance::readFromFile(corrupt([](std::vector<char>&, BinaryHeader& h) { h.xs_offset = 0; })));
+    CHECK_THROWS(TSPInstance::readFromFile(corrupt([](std::vector<char>&, BinaryHeader& h) { h.neighbors_offset += 64; })));
+    CHECK_THROWS(TSPInstance::readFromFile(corrupt([](std::vector<char>&, BinaryHeader& h) { h.file_size += 1; })));
+    CHECK_THROWS(TSPInstance::readFromFile(corrupt([](std::vector<char>& b, BinaryHeader& h) {
+        int bad = h.n;
+        std::memcpy(b.data() + h.neighbors_offset + 40, &bad, sizeof(bad));
+    })));
+    // truncated anywhere: in the header, in the coordinates, in the lists
+    for (size_t size : {(size_t)10, (size_t)100, good.size() / 2, good.size() - 4}) {
+        writeBytes(binary, std::vector<char>(good.begin(), good.begin() + size));
+        CHECK_THROWS(TSPInstance::readFromFile(binary));
+    }
+    // and the untouched file still reads
+    writeBytes(binary, good);
+    CHECK(TSPInstance::readFromFile(binary).content_hash == original.content_hash);
+
+    fs::remove_all(dir);
+    return checkResult("InstanceFileTest");
+}
@@ -0,0 +1,83 @@
+// the result store (ResultStore.h) after a run killed while writing: the complete records read back, the truncated
+// last line is cut from the file, and the next record goes on a line of its own so that a later run finds it
+
+#include "../ResultStore.h"
+#include "Check.h"
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <unistd.h>
+
+namespace fs = std::filesystem;
+
+static ResultStore::Record makeRecord(double obj_value, const std::string& columns) {
+    ResultStore::Record record;
+    record.obj_value = obj_value;
+    record.solving_time = 0.5;
+    record.start_value = obj_value + 10.0;
+    record.construction_time = 0.25;
+    record.columns = columns;
+    return record;
+}
+
+static std::string readText(const std::string& filename) {
+    std::ifstream fin(filename, std::ios::binary);
+    return std::string(std::istreambuf_iterator<char>(fin), std::istreambuf_iterator<char>());
+}
+
+int main() {
+    fs::path dir = fs::temp_directory_path() / ("tsp_result_store_test_" + std::to_string(getpid()));
+    fs::create_directories(dir);
+    std::string filename = (dir / "store.csv").string();
+    const std::string options = "long greedy";
+
+    {
+        ResultStore store(filename);
+        CHECK(store.size() == 0);
+        store.add(1, options, makeRecord(100.0, "100,1,Optimal"));
+        store.add(2, options, makeRecord(200.0, "200,1,Optimal"));
+    }
+    // the run is killed in the middle of the third line
+    std::string complete = readText(filename);
+    {
+        std::ofstream fout(filename, std::ios::app | std::ios::binary);
+        fout << "0000000000000003," << options << ",300,0.5,310,0.25,30";
+    }
+
+    {
+        ResultStore store(filename);
+        CHECK(store.size() == 2);
+        const ResultStore::Record* first = store.find(1, options);
+        CHECK(first != nullptr && first->obj_value == 100.0 && first->columns == "100,1,Optimal");
+        CHECK(first != nullptr && first->start_value == 110.0 && first->construction_time == 0.25);
+        CHECK(store.find(2, options) != nullptr);
+        CHECK(store.find(3, options) == nullptr);
+        CHECK(store.find(1, "long random") == nullptr);
+        store.add(4, options, makeRecord(400.0, "400,1,Optimal"));
+        // a later line for the same key replaces the earlier one
+        store.add(2, options, makeRecord(190.0, "190,1,Optimal"));
+    }
+    // the truncated line is gone, the new records follow the complete ones
+    std::string text = readText(filename);
+    CHECK(text.compare(0, complete.size(), complete) == 0);
+    CHECK(text.compare(complete.size(), 17, "0000000000000004,") == 0);
+    CHECK(text.find("0000000000000003") == std::string::npos);
+
+    {
+        ResultStore store(filename);
+        CHECK(store.size() == 3);
+        CHECK(store.find(3, options) == nullptr);
+        const ResultStore::Record* fourth = store.find(4, options);
+        CHECK(fourth != nullptr && fourth->obj_value == 400.0 && fourth->columns == "400,1,Optimal");
+        const ResultStore::Record* second = store.find(2, options);
+        CHECK(second != nullptr && second->obj_value == 190.0);
+    }
+
+    // a store that cannot be written is an error
+    CHECK_THROWS(ResultStore((dir / "missing" / "store.csv").string()));
+
+    fs::remove_all(dir);
+    return checkResult("ResultStoreTest");
+}
@@ -0,0 +1,82 @@
+// TSPLIB files (TSPLib.cpp) against known values: the rounded EUC_2D distances of a small rectangle, the same EXPLICIT
+// weights in three formats, and the optimal tour of ulysses16 (GEO), 6859 in the TSPLIB documentation.
+// The local search must reach the optimum of the metric rectangle; elsewhere (the EXPLICIT weights are not metric,
+// a 21 local optimum exists) it must stay at or above the optimum.
+// Run from project/Ass2 (make test): the files are read from tests/data
+
+#include "../TSPInstance.h"
+#include "../TSPHeuristic.h"
+#include "Check.h"
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+static const std::string DATA = "tests/data/";
+
+static double tourLength(const TSPInstance& inst, const std::vector<int>& tour) {
+    double sum = 0.0;
+    for (size_t i = 0; i < tour.size(); ++i) sum += inst.dist(tour[i], tour[(i + 1) % tour.size()]);
+    return sum;
+}
+
+static double solve(const TSPInstance& inst) {
+    TSPHeuristic model(inst);
+    model.setThreeOpt(TSPHeuristic::ThreeOptMoves::Full);
+    model.solve();
+    return model.getObjValue();
+}
+
+int main() {
+    // EUC_2D: nint of the Euclidean distance, 2.5 from the center to each corner rounds up to 3
+    {
+        TSPInstance inst = TSPInstance::readFromFile(DATA + "rect5.tsp");
+        CHECK(inst.n == 5);
+        CHECK(inst.metric == TSPInstance::Metric::Euc2D);
+        CHECK(inst.dist(0, 1) == 3.0);
+        CHECK(inst.dist(1, 2) == 4.0);
+        CHECK(inst.dist(0, 2) == 5.0);
+        CHECK(inst.dist(0, 4) == 3.0);
+        CHECK(tourLength(inst, {0, 1, 2, 3, 4}) == 16.0);
+        CHECK(solve(inst) == 16.0);
+        // the lazy distances round as the matrix
+        TSPInstance lazy = TSPInstance::readFromFile(DATA + "rect5.tsp", TSPInstance::DistanceMode::Lazy);
+        CHECK(!lazy.hasCostMatrix());
+        CHECK(lazy.dist(0, 4) == 3.0);
+    }
+
+    // EXPLICIT: the three formats give the same weights and the same instance
+    {
+        const double weights[5][5] = {
+            {0, 3, 4, 2, 7}, {3, 0, 4, 6, 3}, {4, 4, 0, 5, 8}, {2, 6, 5, 0, 6}, {7, 3, 8, 6, 0}};
+        TSPInstance full = TSPInstance::readFromFile(DATA + "explicit5_full.tsp");
+        for (const char* name : {"explicit5_full.tsp", "explicit5_upper.tsp", "explicit5_lower.tsp"}) {
+            // lazy is not available without coordinates, the matrix stays
+            TSPInstance inst = TSPInstance::readFromFile(DATA + name, TSPInstance::DistanceMode::Lazy);
+            CHECK(inst.n == 5);
+            CHECK(inst.metric == TSPInstance::Metric::Explicit);
+            CHECK(!inst.hasCoordinates());
+            CHECK(inst.hasCostMatrix());
+            CHECK(inst.content_hash == full.content_hash);
+            for (int i = 0; i < 5; ++i)
+                for (int j = 0; j < 5; ++j) CHECK(inst.dist(i, j) == weights[i][j]);
+            CHECK(tourLength(inst, {0, 2, 1, 4, 3}) == 19.0);
+            CHECK(solve(inst) >= 19.0);
+        }
+    }
+
+    // GEO: ulysses16 and its optimal tour
+    {
+        TSPInstance inst = TSPInstance::readFromFile(DATA + "ulysses16.tsp");
+        CHECK(inst.n == 16);
+        CHECK(inst.metric == TSPInstance::Metric::Geo);
+        std::vector<int> optimal = {1, 14, 13, 12, 7, 6, 15, 5, 11, 9, 10, 16, 3, 2, 4, 8};
+        for (int& v : optimal) v--;
+        CHECK(tourLength(inst, optimal) == 6859.0);
+        CHECK(solve(inst) >= 6859.0);
+    }
+
+    // what the parser refuses
+    CHECK_THROWS(TSPInstance::readFromFile(DATA + "missing.tsp"));
+
+    return checkResult("TSPLibTest");
+}
@@ -0,0 +1,108 @@
+// the Held-Karp lower bound (TSPLowerBound.h) never exceeds a known tour: the optimum of ulysses16 (6859, GEO), the
+// optimum of the non-metric EXPLICIT weights (19), on 500 random points, where the ascent runs on the candidate
+// graph, the tour of the local search, and above TSPLowerBound::EXACT_MAX_NODES, where the bound comes from the
+// candidate graph with the bounded edges, a greedy tour
+// Run from project/Ass2 (make test): the files are read from tests/data
+
+#include "../TSPInstance.h"
+#include "../TSPConstruction.h"
+#include "../TSPHeuristic.h"
+#include "../TSPLowerBound.h"
+#include "Check.h"
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <unistd.h>
+
+namespace fs = std::filesystem;
+
+static const std::string DATA = "tests/data/";
+
+// n random points in the text format of the generator
+static TSPInstance randomInstance(int n, unsigned seed) {
+    fs::path dir = fs::temp_directory_path() / ("tsp_lower_bound_test_" + std::to_string(getpid()));
+    fs::create_directories(dir);
+    std::string text = (dir / ("instance_" + std::to_string(n) + "_1.dat")).string();
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<double> coord(0.0, 1000.0);
+    {
+        std::ofstream fout(text);
+        fout.precision(17);
+        fout << n << "\n";
+        for (int i = 0; i < n; ++i) fout << coord(rng) << " " << coord(rng) << "\n";
+    }
+    TSPInstance inst = TSPInstance::readFromFile(text, TSPInstance::DistanceMode::Lazy);
+    fs::remove_all(dir);
+    return inst;
+}
+
+// a 2-opt local optimum, full 3-opt takes seconds on 500 nodes
+static double solve(const TSPInstance& inst) {
+    TSPHeuristic model(inst);
+    model.solve();
+    return model.getObjValue();
+}
+
+int main() {
+    // optimal tours known
+    {
+        TSPInstance inst = TSPInstance::readFromFile(DATA + "ulysses16.tsp");
+        TSPLowerBound bound(inst);
+        bound.setUpperBound(solve(inst));
+        bound.solve();
+        CHECK(bound.getProven());
+        CHECK(bound.getBound() <= 6859.0);
+        // rounded distances: the bound is rounded up to an integer
+        CHECK(bound.getBound() == (double)(long)bound.getBound());
+        CHECK(bound.getBound() > 0.9 * 6859.0);
+    }
+    {
+        TSPInstance inst = TSPInstance::readFromFile(DATA + "explicit5_full.tsp");
+        TSPLowerBound bound(inst);
+        bound.setUpperBound(solve(inst));
+        bound.solve();
+        CHECK(bound.getProven());
+        CHECK(bound.getBound() <= 19.0);
+    }
+
+    // more than the nodes of a dense ascent
+    {
+        TSPInstance inst = randomInstance(500, 11);
+        double tour = solve(inst);
+        TSPLowerBound bound(inst);
+        bound.setUpperBound(tour);
+        bound.solve();
+        CHECK(bound.getProven());
+        CHECK(bound.getExact());
+        CHECK(bound.getBound() <= tour);
+        CHECK(bound.getBound() > 0.9 * tour);
+    }
+
+    // too many nodes for the complete graph
+    {
+        const int n = TSPLowerBound::EXACT_MAX_NODES + 2000;
+        TSPInstance inst = randomInstance(n, 13);
+        std::vector<int> order = greedyMatchingTour(inst);
+        double tour = 0.0;
+        for (int i = 0; i < n; ++i) tour += inst.dist(order[i], order[(i + 1) % n]);
+        TSPLowerBound bound(inst);
+        bound.setUpperBound(tour);
+        bound.setMaxIterations(50);
+        bound.solve();
+        CHECK(bound.getProven());
+        CHECK(!bound.getExact());
+        CHECK(bound.getBound() <= tour);
+        CHECK(bound.getBound() > 0.75 * tour);
+    }
+
+    // the step size needs a tour
+    {
+        TSPInstance inst = TSPInstance::readFromFile(DATA + "rect5.tsp");
+        CHECK_THROWS(TSPLowerBound(inst).solve());
+    }
+
+    return checkResult("TSPLowerBoundTest");
+}
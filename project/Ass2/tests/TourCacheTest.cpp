@@ -0,0 +1,111 @@
+// the tour cache (TourCache.h): a revised instance (nodes moved, added and removed) starts from the cached tour of
+// its earlier revision with the expected counts of kept, inserted and dropped nodes, and an unrelated instance
+// gets no starting tour
+
+#include "../TSPInstance.h"
+#include "../TourCache.h"
+#include "Check.h"
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <unistd.h>
+
+namespace fs = std::filesystem;
+
+struct Point {
+    double x, y;
+};
+
+// the text format of the generator
+static TSPInstance writeInstance(const std::string& filename, const std::vector<Point>& points) {
+    {
+        std::ofstream fout(filename);
+        fout.precision(17);
+        fout << points.size() << "\n";
+        for (const Point& p : points) fout << p.x << " " << p.y << "\n";
+    }
+    return TSPInstance::readFromFile(filename);
+}
+
+// a closed tour from node 0 visiting every node once
+static bool closedPermutation(const std::vector<int>& tour, int n) {
+    if ((int)tour.size() != n + 1 || tour.front() != 0 || tour.back() != 0) return false;
+    std::vector<int> sorted(tour.begin(), tour.end() - 1);
+    std::sort(sorted.begin(), sorted.end());
+    for (int i = 0; i < n; ++i) {
+        if (sorted[i] != i) return false;
+    }
+    return true;
+}
+
+int main() {
+    fs::path dir = fs::temp_directory_path() / ("tsp_tour_cache_test_" + std::to_string(getpid()));
+    fs::create_directories(dir);
+    std::string folder = (dir / "tour_cache").string();
+
+    std::mt19937 rng(5);
+    std::uniform_real_distribution<double> coord(0.0, 100.0), far(120.0, 150.0);
+    const int n = 200;
+    std::vector<Point> points(n);
+    for (Point& p : points) p = {coord(rng), coord(rng)};
+    TSPInstance original = writeInstance((dir / "instance_200_1.dat").string(), points);
+    std::vector<int> tour(n + 1);
+    for (int i = 0; i < n; ++i) tour[i] = i;
+    tour[n] = 0;
+    {
+        TourCache cache(folder);
+        CHECK(cache.startTour(original).tour.empty());
+        cache.store(original, tour, 1000.0);
+        // the same instance gets its own tour back
+        TourCache::Start start = cache.startTour(original);
+        CHECK(start.tour == tour);
+        CHECK(start.kept == n && start.inserted == 0 && start.dropped == 0);
+    }
+
+    // the revision, read by a later run: 3 nodes moved far away, one moved by a hair, 4 removed and 5 added. The
+    // far nodes are beyond the matching radius of every cached point, the nudged one within it
+    std::vector<Point> revised = points;
+    for (int v : {5, 6, 7}) revised[v] = {far(rng), far(rng)};
+    revised[10].x += 0.01;
+    for (int v : {80, 60, 40, 20}) revised.erase(revised.begin() + v);
+    for (int i = 0; i < 5; ++i) revised.push_back({far(rng), far(rng)});
+    {
+        TSPInstance inst = writeInstance((dir / "instance_201_1.dat").string(), revised);
+        CHECK(inst.n == n + 1);
+        TourCache cache(folder);
+        TourCache::Start start = cache.startTour(inst);
+        CHECK(start.kept == n - 4 - 3);
+        CHECK(start.inserted == 3 + 5);
+        CHECK(start.dropped == 4 + 3);
+        CHECK(closedPermutation(start.tour, inst.n));
+        // the kept nodes, the first n - 4 but the far ones, are visited in the cached order, here increasing
+        std::vector<int> kept;
+        for (int v : start.tour) {
+            if (v < n - 4 && (v < 5 || v > 7)) kept.push_back(v);
+        }
+        kept.pop_back();
+        CHECK((int)kept.size() == n - 4 - 3);
+        CHECK(std::is_sorted(kept.begin(), kept.end()));
+    }
+
+    // nothing in common with the cached instance
+    {
+        std::vector<Point> other(n);
+        for (Point& p : other) p = {coord(rng), coord(rng)};
+        TSPInstance inst = writeInstance((dir / "instance_200_2.dat").string(), other);
+        TourCache cache(folder);
+        TourCache::Start start = cache.startTour(inst);
+        CHECK(start.tour.empty());
+        CHECK(start.kept == 0);
+    }
+
+    // a tour that misses nodes is refused
+    CHECK_THROWS(TourCache(folder).store(original, std::vector<int>(tour.begin(), tour.begin() + n / 2), 10.0));
+
+    fs::remove_all(dir);
+    return checkResult("TourCacheTest");
+}
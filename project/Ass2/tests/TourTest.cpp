@@ -0,0 +1,72 @@
+// the two Tour layouts (Tour.h) must read the same after the same flips: random flips, short local ones and flips
+// of a whole side, on several sizes; the segments of the two-level list stay within twice their initial size
+
+#include "../Tour.h"
+#include "../TwoLevelList.h"
+#include "Check.h"
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+static void sameTours(int n, unsigned seed) {
+    std::mt19937 rng(seed);
+    std::vector<int> order(n);
+    std::iota(order.begin(), order.end(), 0);
+    std::shuffle(order.begin(), order.end(), rng);
+
+    Tour array(order, Tour::Layout::Array);
+    Tour list(order, Tour::Layout::TwoLevel);
+    std::uniform_int_distribution<int> pick(0, n - 1), near(1, 20);
+    for (int f = 0; f < 20000; ++f) {
+        int a = pick(rng), b;
+        if (f % 3 == 0) {
+            b = pick(rng);
+        } else {
+            // a short path after a, as Lin-Kernighan flips them
+            b = a;
+            for (int s = near(rng); s > 0; --s) b = array.next(b);
+        }
+        array.flip(a, b);
+        list.flip(a, b);
+        if (f % 1000 == 0) {
+            int u = pick(rng), v = pick(rng), w = pick(rng);
+            CHECK(array.next(u) == list.next(u));
+            CHECK(array.prev(u) == list.prev(u));
+            CHECK(array.between(u, v, w) == list.between(u, v, w));
+            CHECK(array.index(v) == list.index(v));
+        }
+    }
+    CHECK(array.closedOrder() == list.closedOrder());
+}
+
+static void boundedSegments(int n, unsigned seed) {
+    std::mt19937 rng(seed);
+    std::vector<int> order(n);
+    std::iota(order.begin(), order.end(), 0);
+    TwoLevelList list(order);
+    int group = n / std::max(1, (int)std::sqrt((double)n));
+    std::uniform_int_distribution<int> pick(0, n - 1);
+    for (int f = 0; f < 50000; ++f) {
+        list.flip(pick(rng), pick(rng));
+        if (f % 5000 == 0) CHECK(list.largestSegment() <= 2 * group);
+    }
+    CHECK(list.largestSegment() <= 2 * group);
+    // every node is still visited once
+    std::vector<char> seen(n, 0);
+    int v = 0;
+    for (int i = 0; i < n; ++i) {
+        CHECK(!seen[v]);
+        seen[v] = 1;
+        v = list.next(v);
+    }
+    CHECK(v == 0);
+}
+
+int main() {
+    for (int n : {5, 16, 100, 1000, 20000}) sameTours(n, 1 + n);
+    for (int n : {1000, 40000}) boundedSegments(n, 7);
+    return checkResult("TourTest");
+}
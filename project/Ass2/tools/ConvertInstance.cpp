@@ -0,0 +1,68 @@
+// convert the text instances (.dat) written by the generator of Ass1, or TSPLIB files with coordinates (.tsp),
+// into binary instances (.tspb, InstanceFile.h)
+// each <name>.dat is written as <name>.tspb next to it, and the solver then reads the binary file instead
+// usage: ./convert_instance [-k <neighbors>] [-q] <file.dat | file.tsp | folder> ...
+//   -k, -q: also store the candidate lists the solver would build with the same options (lk and ils use -k 8 -q)
+
+#include "../TSPInstance.h"
+#include <iostream>
+#include <filesystem>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+static bool convert(const fs::path& input, int k_neighbors, bool quadrant) {
+    fs::path output = fs::path(input).replace_extension(".tspb");
+    try {
+        // the cost matrix is not stored, lazy distances avoid building it
+        TSPInstance inst = TSPInstance::readFromFile(input.string(), TSPInstance::DistanceMode::Lazy);
+        if (k_neighbors > 0) inst.buildNeighborLists(k_neighbors, quadrant);
+        inst.writeBinary(output.string());
+        std::cout << input.string() << " -> " << output.string() << " (n = " << inst.n << ", hash "
+                  << std::hex << inst.content_hash << std::dec << ")" << std::endl;
+    } catch (const std::exception& e) {
+        std::cerr << "Error converting " << input.string() << ": " << e.what() << std::endl;
+        return false;
+    }
+    return true;
+}
+
+int main(int argc, char* argv[]) {
+    int k_neighbors = 0;
+    bool quadrant = false;
+    std::vector<fs::path> inputs;
+    for (int a = 1; a < argc; ++a) {
+        std::string arg = argv[a];
+        if (arg == "-k" && a + 1 < argc) {
+            std::istringstream ss(argv[++a]);
+            if (!(ss >> k_neighbors) || !(ss >> std::ws).eof()) {
+                std::cerr << "Invalid value for -k: " << argv[a] << std::endl;
+                return 1;
+            }
+        } else if (arg == "-q") {
+            quadrant = true;
+        } else {
+            inputs.push_back(arg);
+        }
+    }
+    if (inputs.empty()) {
+        std::cerr << "usage: convert_instance [-k <neighbors>] [-q] <file.dat | file.tsp | folder> ..." << std::endl;
+        return 1;
+    }
+
+    bool ok = true;
+    for (const fs::path& input : inputs) {
+        if (!fs::is_directory(input)) {
+            ok = convert(input, k_neighbors, quadrant) && ok;
+            continue;
+        }
+        for (const auto& entry : fs::directory_iterator(input)) {
+            if (entry.is_regular_file() && (entry.path().extension() == ".dat" || entry.path().extension() == ".tsp")) {
+                ok = convert(entry.path(), k_neighbors, quadrant) && ok;
+            }
+        }
+    }
+    return ok ? 0 : 1;
+}